@@ -0,0 +1,145 @@
+#include "anytime.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <igraph.h>
+
+static double elapsed_time(stopwatch_point_t* start)
+{
+    stopwatch_point_t now;
+    create_stopwatch_point(&now);
+
+    stopwatch_t elapsed;
+    create_stopwatch(start, &now, &elapsed);
+
+    return elapsed.real_time;
+}
+
+bool budget_exhausted(stopwatch_point_t* start, double budget,
+    diameter_bound_t* bound)
+{
+    if (budget <= 0)
+    {
+        return false;
+    }
+
+    double elapsed = elapsed_time(start);
+    if (elapsed < budget)
+    {
+        return false;
+    }
+
+    fprintf(stderr, "[%fs] Time budget exhausted, diameter bound: %d\n",
+            elapsed, bound->diameter);
+    return true;
+}
+
+igraph_integer_t anytime_double_sweep(bfs_t* bfs, clusters_t* clusters,
+    igraph_integer_t starting_community, diameter_bound_t* bound,
+    stopwatch_point_t* start, double budget, igraph_integer_t* bfs_count)
+{
+    igraph_integer_t vcount = bfs->graph->vcount;
+
+    // The peripheral vertices waiting to be used as starts, from the end of
+    // the bound found before
+    uint32_t* peripheral = malloc(vcount * sizeof(uint32_t));
+    size_t peripheral_head = 0;
+    size_t peripheral_tail = 0;
+    bool* started = calloc(vcount, sizeof(bool));
+    started[bound->from] = true;
+    if (!started[bound->to])
+    {
+        peripheral[peripheral_tail++] = bound->to;
+    }
+
+    igraph_integer_t count = 0;
+    uint64_t position = clusters->offsets[starting_community];
+    uint64_t end = clusters->offsets[starting_community + 1];
+    bool community_turn = true;
+
+    fprintf(stderr, "[%fs] Diameter bound: %d\n", elapsed_time(start),
+            bound->diameter);
+
+    while (elapsed_time(start) < budget)
+    {
+        // Take the next vertex of the community and the next peripheral one
+        // in turn, so that a large community does not take the whole budget
+        igraph_integer_t source = -1;
+        bool community_start = false;
+
+        for (int turn = 0; turn < 2 && source == -1; ++turn)
+        {
+            if (community_turn)
+            {
+                for (; position < end && source == -1; ++position)
+                {
+                    uint32_t vertex = clusters->vertices[position];
+                    if (!started[vertex])
+                    {
+                        source = vertex;
+                        community_start = true;
+                    }
+                }
+            }
+            else
+            {
+                while (source == -1 && peripheral_head < peripheral_tail)
+                {
+                    uint32_t vertex = peripheral[peripheral_head++];
+                    if (!started[vertex])
+                    {
+                        source = vertex;
+                    }
+                }
+            }
+            community_turn = !community_turn;
+        }
+
+        if (source == -1)
+        {
+            break;
+        }
+
+        // A community start is double swept, a peripheral one is the second
+        // sweep of the sweep that found it
+        for (int sweep = 0; sweep < (community_start ? 2 : 1); ++sweep)
+        {
+            started[source] = true;
+            sweep_result_t stats = bfs_sweep(bfs, source);
+            count += 1;
+
+            if (stats.max_distance > bound->diameter)
+            {
+                bound->diameter = stats.max_distance;
+                bound->from = source;
+                bound->to = stats.last_vertex;
+                fprintf(stderr, "[%fs] Diameter bound: %d\n",
+                        elapsed_time(start), bound->diameter);
+            }
+
+            source = stats.last_vertex;
+            if (started[source])
+            {
+                break;
+            }
+        }
+
+        // Keep the last farthest vertex for later
+        if (!started[source])
+        {
+            peripheral[peripheral_tail++] = source;
+        }
+    }
+
+    free(started);
+    free(peripheral);
+
+    if (bfs_count)
+    {
+        *bfs_count = count;
+    }
+
+    return bound->diameter;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include <igraph_datatype.h>
+
+#include "bfs.h"
+#include "clusters.h"
+#include "stopwatch.h"
+
+typedef struct diameter_bound
+{
+    // A lower bound of the diameter, the distance between from and to
+    igraph_integer_t diameter;
+    // The source of the sweep that found the bound
+    igraph_integer_t from;
+    // The farthest vertex of that sweep
+    igraph_integer_t to;
+} diameter_bound_t;
+
+/**
+ * @brief Check whether a time budget ran out, between the phases of the
+ *        estimation, printing the bound found so far on stderr if so
+ * @param start The point the budget is counted from
+ * @param budget The budget in seconds (0 for no budget)
+ * @param bound The best bound found so far
+ * @return Whether the budget ran out
+ */
+bool budget_exhausted(stopwatch_point_t* start, double budget,
+    diameter_bound_t* bound);
+
+/**
+ * @brief Estimate the diameter until a time budget runs out: double sweeps
+ *        start from the vertices of a community, alternating with sweeps
+ *        from the peripheral vertices found so far. The bound is printed on
+ *        stderr with its timestamp each time it improves.
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
+ * @param starting_community The community starts are taken from this
+ *                           community
+ * @param bound The bound found before, whose farthest vertex is the first
+ *              peripheral start, updated with the best bound (in/out)
+ * @param start The point the budget is counted from
+ * @param budget The budget in seconds
+ * @param bfs_count The number of breadth first searches done (out, can be NULL)
+ * @return The best lower bound of the diameter found in the budget
+ */
+igraph_integer_t anytime_double_sweep(bfs_t* bfs, clusters_t* clusters,
+    igraph_integer_t starting_community, diameter_bound_t* bound,
+    stopwatch_point_t* start, double budget, igraph_integer_t* bfs_count);
@@ -1,83 +1,170 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <string.h>
 
 #include <igraph.h>
+#include <omp.h>
 
+#include "bfs.h"
+#include "clusters.h"
+#include "csr.h"
 #include "display.h"
+#include "louvain.h"
+#include "options.h"
 #include "quotient.h"
+#include "report.h"
 #include "sweep.h"
 #include "communities.h"
 #include "benchmark.h"
 
-static igraph_integer_t normal_double_sweep(igraph_t* graph, bool verbose)
+static igraph_integer_t normal_double_sweep(csr_t* csr, bool verbose,
+        benchmark_record_t* record)
 {
     (void) verbose;
 
-    return double_sweep(graph);
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
+
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
+
+    igraph_integer_t diameter = double_sweep(&bfs);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
+
+    destroy_bfs(&bfs);
+
+    return diameter;
 }
 
-static igraph_integer_t quotient_starting_double_sweep_louvain(igraph_t* graph,
-        bool verbose)
+static igraph_integer_t direction_optimizing_double_sweep(csr_t* csr,
+        bool verbose, benchmark_record_t* record)
 {
-    // Compute the communities using louvain
-    igraph_vector_t membership;
-    igraph_integer_t nb_clusters =
-            compute_communities_louvain(graph, &membership);
+    (void) verbose;
 
-    // Compute the quotient graph
-    igraph_t quotient;
-    quotient_graph(graph, nb_clusters, &membership, &quotient);
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
 
-    // Get the exact diameter
-    igraph_integer_t quotient_diameter;
-    igraph_vector_t quotient_longest_path;
-    igraph_vector_init(&quotient_longest_path, 0);
-    igraph_diameter(&quotient, &quotient_diameter, NULL, NULL,
-                    &quotient_longest_path, false, true);
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    bfs.engine = BFS_ENGINE_DIRECTION_OPTIMIZING;
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
 
-    // Destroy the quotient graph
-    igraph_destroy(&quotient);
+    igraph_integer_t diameter = double_sweep(&bfs);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
 
-    // Take a starting community for double-sweep
-    igraph_integer_t starting_community = VECTOR(quotient_longest_path)[0];
+    destroy_bfs(&bfs);
 
-    // Destroy the longest path vector
-    igraph_vector_destroy(&quotient_longest_path);
+    return diameter;
+}
 
-    // Compute the double sweep starting from the vertices in a community
-    igraph_integer_t diameter = double_sweep_from_community_tries(graph,
-        &membership, starting_community, 3, verbose);
+static igraph_integer_t parallel_double_sweep(csr_t* csr, bool verbose,
+        benchmark_record_t* record)
+{
+    (void) verbose;
 
-    // Destroy the communities
-    igraph_vector_destroy(&membership);
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
+
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    bfs.threads = omp_get_num_procs();
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
+
+    igraph_integer_t diameter = double_sweep(&bfs);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
+
+    destroy_bfs(&bfs);
+
+    return diameter;
+}
+
+static igraph_integer_t normal_four_sweep(csr_t* csr, bool verbose,
+        benchmark_record_t* record)
+{
+    (void) verbose;
+
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
+
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
+
+    igraph_integer_t diameter = four_sweep(&bfs);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
+
+    destroy_bfs(&bfs);
 
     return diameter;
 }
 
-static igraph_integer_t quotient_starting_double_sweep_leiden(igraph_t* graph,
-        bool verbose)
+static igraph_integer_t normal_sum_sweep(csr_t* csr, bool verbose,
+        benchmark_record_t* record)
 {
-    // Compute the communities using leiden
-    igraph_integer_t ecount = igraph_ecount(graph);
-    igraph_real_t resolution = 1.0 / (2.0 * ecount);
-    igraph_real_t beta = 0.01;
+    (void) verbose;
+
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
+
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
+
+    igraph_integer_t diameter = sum_sweep(&bfs, SUM_SWEEP_DEFAULT_SWEEPS);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
+
+    destroy_bfs(&bfs);
+
+    return diameter;
+}
+
+static igraph_integer_t quotient_starting_double_sweep(csr_t* csr,
+        community_algorithm_t algorithm, int threads, bool verbose,
+        benchmark_record_t* record)
+{
+    stopwatch_point_t point;
+    create_stopwatch_point(&point);
+
+    bfs_t bfs;
+    init_bfs(&bfs, csr);
+    bfs.threads = threads;
+    lap_phase(record, BENCHMARK_PHASE_CSR, &point);
+
+    // The igraph graph of the csr, for the quotient graph (and the
+    // communities with Leiden or Louvain)
+    igraph_t graph;
+    csr_graph(csr, &graph);
+    lap_phase(record, BENCHMARK_PHASE_GRAPH, &point);
+
+    // Compute the communities, with the default parameters of the algorithm
+    options_t options;
+    options.community_algorithm = algorithm;
+    options.label_propagation_cutoff = LABEL_PROPAGATION_DEFAULT_CUTOFF;
+    options.voronoi_seeds = 0;
+    options.voronoi_seeding = VORONOI_SEEDING_DEGREE;
     igraph_vector_t membership;
-    igraph_integer_t nb_clusters = compute_communities_leiden(graph,
-        &membership, resolution, beta);
+    igraph_integer_t nb_clusters = compute_communities(&graph, &bfs,
+        &options, &membership, verbose);
+    lap_phase(record, BENCHMARK_PHASE_COMMUNITIES, &point);
 
     // Compute the quotient graph
     igraph_t quotient;
-    quotient_graph(graph, nb_clusters, &membership, &quotient);
+    quotient_graph(&graph, nb_clusters, &membership, &quotient, NULL,
+        threads);
+    lap_phase(record, BENCHMARK_PHASE_QUOTIENT, &point);
 
     // Get the exact diameter
-    igraph_integer_t quotient_diameter;
+    bool exact;
     igraph_vector_t quotient_longest_path;
     igraph_vector_init(&quotient_longest_path, 0);
-    igraph_diameter(&quotient, &quotient_diameter, NULL, NULL,
-        &quotient_longest_path, false, true);
+    quotient_diameter(&quotient, 0, &quotient_longest_path, &exact);
+    lap_phase(record, BENCHMARK_PHASE_QUOTIENT_DIAMETER, &point);
 
-    // Destroy the quotient graph
+    // Destroy the quotient graph, and the graph
     igraph_destroy(&quotient);
+    igraph_destroy(&graph);
 
     // Take a starting community for double-sweep
     igraph_integer_t starting_community = VECTOR(quotient_longest_path)[0];
@@ -86,8 +173,13 @@ static igraph_integer_t quotient_starting_double_sweep_leiden(igraph_t* graph,
     igraph_vector_destroy(&quotient_longest_path);
 
     // Compute the double sweep starting from the vertices in a community
-    igraph_integer_t diameter = double_sweep_from_community_tries(graph,
-        &membership, starting_community, 3, verbose);
+    clusters_t clusters;
+    init_clusters(&clusters, nb_clusters, &membership);
+    igraph_integer_t diameter = double_sweep_from_community_tries(&bfs,
+        &clusters, starting_community, 3, verbose);
+    lap_phase(record, BENCHMARK_PHASE_SWEEPS, &point);
+    destroy_clusters(&clusters);
+    destroy_bfs(&bfs);
 
     // Destroy the communities
     igraph_vector_destroy(&membership);
@@ -95,30 +187,175 @@ static igraph_integer_t quotient_starting_double_sweep_leiden(igraph_t* graph,
     return diameter;
 }
 
+static igraph_integer_t quotient_starting_double_sweep_leiden(csr_t* csr,
+        bool verbose, benchmark_record_t* record)
+{
+    return quotient_starting_double_sweep(csr, COMMUNITY_ALGORITHM_LEIDEN, 1,
+        verbose, record);
+}
+
+static igraph_integer_t quotient_starting_double_sweep_louvain(csr_t* csr,
+        bool verbose, benchmark_record_t* record)
+{
+    return quotient_starting_double_sweep(csr, COMMUNITY_ALGORITHM_LOUVAIN, 1,
+        verbose, record);
+}
+
+static igraph_integer_t quotient_starting_double_sweep_parallel_louvain(
+        csr_t* csr, bool verbose, benchmark_record_t* record)
+{
+    // With all the cores
+    return quotient_starting_double_sweep(csr,
+        COMMUNITY_ALGORITHM_PARALLEL_LOUVAIN, omp_get_num_procs(), verbose,
+        record);
+}
+
+static igraph_integer_t quotient_starting_double_sweep_voronoi(
+        csr_t* csr, bool verbose, benchmark_record_t* record)
+{
+    return quotient_starting_double_sweep(csr, COMMUNITY_ALGORITHM_VORONOI, 1,
+        verbose, record);
+}
+
+static igraph_integer_t quotient_starting_double_sweep_label_propagation(
+        csr_t* csr, bool verbose, benchmark_record_t* record)
+{
+    // With all the cores
+    return quotient_starting_double_sweep(csr,
+        COMMUNITY_ALGORITHM_LABEL_PROPAGATION, omp_get_num_procs(), verbose,
+        record);
+}
+
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s [graph]\n", argv[0]);
+    benchmark_options_t options;
+    options.warm = false;
+    options.flush_cache = false;
+    report_format_t format = REPORT_FORMAT_TEXT;
+
+    int current_arg = 1;
+    while (current_arg < argc - 1)
+    {
+        if (strcmp(argv[current_arg], "--warm") == 0)
+        {
+            options.warm = true;
+        }
+        else if (strcmp(argv[current_arg], "--flush-cache") == 0)
+        {
+            options.flush_cache = true;
+        }
+        else if (strcmp(argv[current_arg], "--format") == 0
+                 && current_arg + 2 < argc)
+        {
+            current_arg += 1;
+            if (strcmp(argv[current_arg], "text") == 0)
+            {
+                format = REPORT_FORMAT_TEXT;
+            }
+            else if (strcmp(argv[current_arg], "json") == 0)
+            {
+                format = REPORT_FORMAT_JSON;
+            }
+            else if (strcmp(argv[current_arg], "csv") == 0)
+            {
+                format = REPORT_FORMAT_CSV;
+            }
+            else
+            {
+                break;
+            }
+        }
+        else
+        {
+            break;
+        }
+        current_arg += 1;
+    }
+
+    if (current_arg != argc - 1) {
+        fprintf(stderr, "Usage: %s [--warm] [--flush-cache] "
+                        "[--format text|json|csv] [graph]\n", argv[0]);
+        fprintf(stderr, "    --warm: load the graph once and run the tries on it, instead of loading it before each try\n");
+        fprintf(stderr, "    --flush-cache: evict the caches before each try, and the graph file from the page cache before each load\n");
+        fprintf(stderr, "    --format: print the averages as text (default), or every try with the time of each phase and their statistics as json or csv\n");
         return 1;
     }
+    char* path = argv[current_arg];
+
+    // Count the cycles, instructions and misses of the process, before the
+    // first parallel region creates the threads
+    if (!open_stopwatch_counters())
+    {
+        fprintf(stderr, "Hardware counters not available\n");
+    }
+
+    begin_report(&options.report, format, stdout);
 
     int min_tries = 3;
     int min_time = 60;
 
-    BENCHMARK(argv[1],
+    BENCHMARK(path,
             normal_double_sweep,
             min_tries,
-            min_time);
+            min_time,
+            &options);
 
-    BENCHMARK(argv[1],
+    BENCHMARK(path,
+            normal_four_sweep,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            normal_sum_sweep,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            direction_optimizing_double_sweep,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            parallel_double_sweep,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
               quotient_starting_double_sweep_leiden,
               min_tries,
-              min_time);
+              min_time,
+              &options);
 
-    BENCHMARK(argv[1],
+    BENCHMARK(path,
             quotient_starting_double_sweep_louvain,
             min_tries,
-            min_time);
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            quotient_starting_double_sweep_parallel_louvain,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            quotient_starting_double_sweep_voronoi,
+            min_tries,
+            min_time,
+            &options);
+
+    BENCHMARK(path,
+            quotient_starting_double_sweep_label_propagation,
+            min_tries,
+            min_time,
+            &options);
+
+    end_report(&options.report);
+    close_stopwatch_counters();
 
     return 0;
 }
@@ -1,39 +1,146 @@
 #pragma once
 
+#include <errno.h>
+#include <fcntl.h>
 #include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include <igraph.h>
+#include <omp.h>
 
+#include "csr.h"
+#include "loader.h"
+#include "report.h"
 #include "stopwatch.h"
 
-#define BENCHMARK(path, function, min_tries, min_time)                       \
+// Larger than the last level caches, to evict them
+#define BENCHMARK_FLUSH_SIZE (256 << 20)
+
+typedef struct benchmark_options
+{
+    // Load the graph once, and run all the tries on it
+    bool warm;
+
+    // Evict the caches before each try (and the file from the page cache
+    // before each load)
+    bool flush_cache;
+
+    // The machine readable output of the tries, unless in text format
+    report_t report;
+} benchmark_options_t;
+
+/**
+ * @brief Evict the processor caches by going through a large buffer
+ */
+static inline void flush_cache(void)
+{
+    volatile char* buffer = malloc(BENCHMARK_FLUSH_SIZE);
+    if (!buffer)
+    {
+        fprintf(stderr, "Cannot allocate the buffer evicting the caches\n");
+        return;
+    }
+
+    for (size_t i = 0; i < BENCHMARK_FLUSH_SIZE; i += 64)
+    {
+        buffer[i] = i;
+    }
+    free((char*) buffer);
+}
+
+// Load the csr of the graph, a binary csr file is only mapped (from the page
+// cache once read). The benchmark stops if the graph cannot be loaded, the
+// tries would measure nothing
+#define BENCHMARK_LOAD(path, csr, options, load_elapsed)                     \
+    do {                                                                     \
+        FILE* file = fopen((path), "r");                                     \
+        if (!file)                                                           \
+        {                                                                    \
+            fprintf(stderr, "%s: %s\n", (path), strerror(errno));            \
+            exit(EXIT_FAILURE);                                              \
+        }                                                                    \
+                                                                             \
+        if ((options)->flush_cache)                                          \
+        {                                                                    \
+            posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);          \
+        }                                                                    \
+                                                                             \
+        stopwatch_point_t load_start;                                        \
+        create_stopwatch_point(&load_start);                                 \
+        bool read = load_graph(file, NULL, (csr), omp_get_num_procs());      \
+        stopwatch_point_t load_end;                                          \
+        create_stopwatch_point(&load_end);                                   \
+        increment_stopwatch(&load_start, &load_end, (load_elapsed));         \
+                                                                             \
+        fclose(file);                                                        \
+        if (!read)                                                           \
+        {                                                                    \
+            fprintf(stderr, "Cannot load the graph %s\n", (path));           \
+            exit(EXIT_FAILURE);                                              \
+        }                                                                    \
+    } while(false)
+
+#define BENCHMARK(path, function, min_tries, min_time, options)              \
     do {                                                                     \
         stopwatch_t global_elapsed;                                          \
         stopwatch_t total_elapsed;                                           \
+        stopwatch_t load_elapsed;                                            \
         init_stopwatch(&total_elapsed);                                      \
+        init_stopwatch(&load_elapsed);                                       \
         double total_diameter = 0;                                           \
+        bool text = (options)->report.format == REPORT_FORMAT_TEXT;          \
+        benchmark_record_t* records = NULL;                                  \
+        int capacity = 0;                                                    \
                                                                              \
-        printf("--------------------------------------------------\n");    \
-        printf("FUNCTION: %s\n\n", #function);                                 \
+        if (text)                                                            \
+        {                                                                    \
+            printf("--------------------------------------------------\n"); \
+            printf("FUNCTION: %s\n\n", #function);                           \
+        }                                                                    \
                                                                              \
         stopwatch_point_t global_start;                                      \
         create_stopwatch_point(&global_start);                               \
                                                                              \
+        csr_t csr;                                                           \
+        if ((options)->warm)                                                 \
+        {                                                                    \
+            fprintf(stderr, "Read file once\n");                             \
+            BENCHMARK_LOAD(path, &csr, options, &load_elapsed);              \
+        }                                                                    \
+                                                                             \
         int tries = 0;                                                       \
                                                                              \
         while ((tries < min_tries) || (global_elapsed.real_time < min_time)) \
         {                                                                    \
-            if (tries < min_tries)                                           \
+            if (tries == capacity)                                           \
             {                                                                \
-                fprintf(stderr, "Read file ... ");                         \
+                capacity = capacity ? 2 * capacity : 16;                     \
+                records = realloc(records,                                   \
+                    capacity * sizeof(benchmark_record_t));                  \
             }                                                                \
+            benchmark_record_t* record = &records[tries];                    \
+            memset(record, 0, sizeof(benchmark_record_t));                   \
                                                                              \
-            FILE* file = fopen((path), "r");                                 \
-            igraph_t graph;                                                  \
-            igraph_read_graph_edgelist(&graph, file, 0, false);              \
-            fclose(file);                                                    \
+            if (!(options)->warm)                                            \
+            {                                                                \
+                if (tries < min_tries)                                       \
+                {                                                            \
+                    fprintf(stderr, "Read file ... ");                       \
+                }                                                            \
+                                                                             \
+                stopwatch_t loaded = load_elapsed;                           \
+                BENCHMARK_LOAD(path, &csr, options, &load_elapsed);          \
+                subtract_stopwatch(&load_elapsed, &loaded,                   \
+                    &record->phases[BENCHMARK_PHASE_LOAD]);                  \
+            }                                                                \
+                                                                             \
+            if ((options)->flush_cache)                                      \
+            {                                                                \
+                flush_cache();                                               \
+            }                                                                \
                                                                              \
             if (tries < min_tries)                                           \
             {                                                                \
@@ -43,11 +150,15 @@
             stopwatch_point_t start_point;                                   \
             create_stopwatch_point(&start_point);                            \
                                                                              \
-            igraph_integer_t diameter = function(&graph, tries < min_tries); \
+            igraph_integer_t diameter = function(&csr, tries < min_tries,    \
+                record);                                                     \
                                                                              \
             stopwatch_point_t end_point;                                     \
             create_stopwatch_point(&end_point);                              \
                                                                              \
+            create_stopwatch(&start_point, &end_point, &record->total);      \
+            record->diameter = diameter;                                     \
+                                                                             \
             if (tries < min_tries)                                           \
             {                                                                \
                 fprintf(stderr, "diameter: %d\n", diameter);                 \
@@ -56,7 +167,10 @@
             total_diameter += diameter;                                      \
             increment_stopwatch(&start_point, &end_point, &total_elapsed);   \
                                                                              \
-            igraph_destroy(&graph);                                          \
+            if (!(options)->warm)                                            \
+            {                                                                \
+                destroy_csr(&csr);                                           \
+            }                                                                \
                                                                              \
             tries += 1;                                                      \
                                                                              \
@@ -65,24 +179,53 @@
             create_stopwatch(&global_start, &current_time, &global_elapsed); \
         }                                                                    \
                                                                              \
-        stopwatch_t result;                                                  \
+        if ((options)->warm)                                                 \
+        {                                                                    \
+            destroy_csr(&csr);                                               \
+        }                                                                    \
+                                                                             \
+        if (text)                                                            \
+        {                                                                    \
+            stopwatch_t result;                                              \
+                                                                             \
+            printf("\n- Tries:\t\t\t\t%d\n", tries);                         \
+            printf("- Mode:\t\t\t\t\t%s%s\n",                                \
+                (options)->warm ? "warm (loaded once)"                       \
+                    : "cold (loaded per try)",                               \
+                (options)->flush_cache ? ", caches flushed" : "");           \
+                                                                             \
+            printf("- Total elapsed:\t\t\t");                                \
+            print_stopwatch(&global_elapsed);                                \
                                                                              \
-        printf("\n- Tries:\t\t\t\t%d\n", tries);                             \
+            printf("\n- Total elapsed (without file loading):\t");           \
+            print_stopwatch(&total_elapsed);                                 \
                                                                              \
-        printf("- Total elapsed:\t\t\t");                                    \
-        print_stopwatch(&global_elapsed);                                    \
+            printf("\n- Loading time:\t\t\t\t");                             \
+            print_stopwatch(&load_elapsed);                                  \
                                                                              \
-        printf("\n- Total elapsed (without file loading):\t");               \
-        print_stopwatch(&total_elapsed);                                     \
+            if (!(options)->warm)                                            \
+            {                                                                \
+                printf("\n- Average loading time:\t\t\t");                   \
+                multiply_scalar_stopwatch(&load_elapsed, 1.0 / tries,        \
+                    &result);                                                \
+                print_stopwatch(&result);                                    \
+            }                                                                \
                                                                              \
-        printf("\n- Loading time:\t\t\t\t%fs\n",                             \
-            global_elapsed.real_time - total_elapsed.real_time);             \
+            printf("\n- Average time per try:\t\t\t");                       \
+            multiply_scalar_stopwatch(&total_elapsed, 1.0 / tries, &result); \
+            print_stopwatch(&result);                                        \
                                                                              \
-        printf("- Average time per try:\t\t\t");                             \
-        multiply_scalar_stopwatch(&total_elapsed, 1.0 / tries, &result);     \
-        print_stopwatch(&result);                                            \
+            printf("\n- Average try per second:\t\t%f try/s\n",              \
+                tries / total_elapsed.real_time);                            \
+            printf("- Average diameter:\t\t\t%f\n\n\n",                      \
+                total_diameter / tries);                                     \
+        }                                                                    \
+        else                                                                 \
+        {                                                                    \
+            report_function(&(options)->report, #function,                   \
+                (options)->warm, (options)->flush_cache,                     \
+                &load_elapsed, records, tries);                              \
+        }                                                                    \
                                                                              \
-        printf("\n- Average try per second:\t\t%f try/s\n",                  \
-            tries / total_elapsed.real_time);                                \
-        printf("- Average diameter:\t\t\t%f\n\n\n", total_diameter / tries); \
+        free(records);                                                       \
     } while(false)
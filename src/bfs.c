@@ -0,0 +1,501 @@
+#include "bfs.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <igraph.h>
+
+// Switch to bottom-up when the frontier has more than 1/ALPHA of the
+// unexplored edges, and back to top-down when it has less than 1/BETA of
+// the vertices (Beamer, Asanovic, Patterson)
+#define BFS_ALPHA 14
+#define BFS_BETA 24
+
+// The number of frontier vertices given at once to a thread
+#define BFS_CHUNK 64
+
+#define BITMAP_WORDS(n) (((size_t) (n) + 63) / 64)
+
+void init_bfs(bfs_t* bfs, csr_t* graph)
+{
+    bfs->graph = graph;
+    bfs->engine = BFS_ENGINE_TOP_DOWN;
+    bfs->threads = 1;
+    bfs->claims = NULL;
+    bfs->chunk_offsets = NULL;
+    bfs->stamp = 0;
+    bfs->queue = malloc(graph->vcount * sizeof(uint32_t));
+    bfs->marks = calloc(graph->vcount, sizeof(uint32_t));
+    bfs->epoch = 0;
+    bfs->frontier = malloc(BITMAP_WORDS(graph->vcount) * sizeof(uint64_t));
+    bfs->next = malloc(BITMAP_WORDS(graph->vcount) * sizeof(uint64_t));
+    bfs->batched = false;
+    bfs->seen = NULL;
+    bfs->visit = NULL;
+    bfs->visit_next = NULL;
+}
+
+void destroy_bfs(bfs_t* bfs)
+{
+    free(bfs->chunk_offsets);
+    free(bfs->claims);
+    free(bfs->visit_next);
+    free(bfs->visit);
+    free(bfs->seen);
+    free(bfs->next);
+    free(bfs->frontier);
+    free(bfs->marks);
+    free(bfs->queue);
+}
+
+static uint32_t next_epoch(bfs_t* bfs)
+{
+    bfs->epoch += 1;
+
+    // Clear the marks when the epoch wraps around
+    if (bfs->epoch == UINT32_MAX)
+    {
+        memset(bfs->marks, 0, bfs->graph->vcount * sizeof(uint32_t));
+        bfs->epoch = 1;
+    }
+
+    return bfs->epoch;
+}
+
+// When levels is NULL the code using it is folded away by the compiler
+static inline sweep_result_t top_down_sweep(bfs_t* bfs, uint32_t source,
+    size_t* levels)
+{
+    const uint64_t* offsets = bfs->graph->offsets;
+    const uint32_t* neighbors = bfs->graph->neighbors;
+    uint32_t* queue = bfs->queue;
+    uint32_t* marks = bfs->marks;
+    uint32_t epoch = next_epoch(bfs);
+
+    sweep_result_t result;
+    result.max_distance = 0;
+
+    queue[0] = source;
+    marks[source] = epoch;
+
+    size_t head = 0;
+    size_t tail = 1;
+    size_t level_end = 1;
+
+    if (levels)
+    {
+        levels[0] = 0;
+        levels[1] = 1;
+    }
+
+    while (head < tail)
+    {
+        uint32_t vertex = queue[head++];
+
+        for (uint64_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+        {
+            uint32_t neighbor = neighbors[i];
+            if (marks[neighbor] != epoch)
+            {
+                marks[neighbor] = epoch;
+                queue[tail++] = neighbor;
+            }
+        }
+
+        // Go to the next level
+        if (head == level_end && tail > level_end)
+        {
+            result.max_distance += 1;
+            level_end = tail;
+
+            if (levels)
+            {
+                levels[result.max_distance + 1] = tail;
+            }
+        }
+    }
+
+    // Same as the last vertex given to an igraph_bfs callback
+    result.last_vertex = queue[tail - 1];
+
+    return result;
+}
+
+// Each level of the parallel sweep is expanded in three passes over the
+// frontier edges: every unvisited neighbor is claimed by its first parent in
+// the frontier order, the claimed vertices of each chunk are counted, then
+// written at their prefix sum offset. The queue ends up in the exact order of
+// the serial sweep, so the last vertex is the same.
+static sweep_result_t parallel_top_down_sweep(bfs_t* bfs, uint32_t source)
+{
+    uint32_t vcount = bfs->graph->vcount;
+    const uint64_t* offsets = bfs->graph->offsets;
+    const uint32_t* neighbors = bfs->graph->neighbors;
+    uint32_t* queue = bfs->queue;
+    uint32_t* marks = bfs->marks;
+    uint32_t epoch = next_epoch(bfs);
+
+    if (!bfs->claims)
+    {
+        bfs->claims = calloc(vcount, sizeof(uint64_t));
+        bfs->chunk_offsets = malloc((vcount / BFS_CHUNK + 2) * sizeof(size_t));
+    }
+
+    uint64_t* claims = bfs->claims;
+    size_t* chunk_offsets = bfs->chunk_offsets;
+
+    sweep_result_t result;
+    result.max_distance = 0;
+
+    queue[0] = source;
+    marks[source] = epoch;
+
+    // The current level is queue[head, tail)
+    size_t head = 0;
+    size_t tail = 1;
+
+    while (true)
+    {
+        // A claim is the level stamp followed by the position of the parent
+        bfs->stamp += 1;
+        if (bfs->stamp == UINT32_MAX)
+        {
+            memset(claims, 0, vcount * sizeof(uint64_t));
+            bfs->stamp = 1;
+        }
+        uint64_t stamp = (uint64_t) bfs->stamp << 32;
+
+        size_t chunks = (tail - head + BFS_CHUNK - 1) / BFS_CHUNK;
+
+        #pragma omp parallel num_threads(bfs->threads)
+        {
+            // Claim the unvisited neighbors, the first parent wins
+            #pragma omp for schedule(dynamic, BFS_CHUNK)
+            for (size_t i = head; i < tail; ++i)
+            {
+                uint64_t claim = stamp | (i - head);
+                uint32_t vertex = queue[i];
+                for (uint64_t j = offsets[vertex]; j < offsets[vertex + 1]; ++j)
+                {
+                    uint32_t neighbor = neighbors[j];
+                    if (marks[neighbor] == epoch)
+                    {
+                        continue;
+                    }
+
+                    uint64_t current = __atomic_load_n(&claims[neighbor],
+                        __ATOMIC_RELAXED);
+                    while ((current & ~UINT64_C(0xFFFFFFFF)) != stamp
+                        || current > claim)
+                    {
+                        if (__atomic_compare_exchange_n(&claims[neighbor],
+                            &current, claim, true, __ATOMIC_RELAXED,
+                            __ATOMIC_RELAXED))
+                        {
+                            break;
+                        }
+                    }
+                }
+            }
+
+            // Count the vertices claimed by each chunk (the neighbors are
+            // sorted, so parallel edges are next to each other)
+            #pragma omp for schedule(dynamic, 1)
+            for (size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                size_t count = 0;
+                size_t end = head + (chunk + 1) * BFS_CHUNK;
+                for (size_t i = head + chunk * BFS_CHUNK; i < end && i < tail; ++i)
+                {
+                    uint64_t claim = stamp | (i - head);
+                    uint32_t vertex = queue[i];
+                    for (uint64_t j = offsets[vertex]; j < offsets[vertex + 1]; ++j)
+                    {
+                        if (claims[neighbors[j]] == claim
+                            && (j == offsets[vertex]
+                                || neighbors[j] != neighbors[j - 1]))
+                        {
+                            count += 1;
+                        }
+                    }
+                }
+                chunk_offsets[chunk + 1] = count;
+            }
+
+            #pragma omp single
+            {
+                chunk_offsets[0] = tail;
+                for (size_t chunk = 0; chunk < chunks; ++chunk)
+                {
+                    chunk_offsets[chunk + 1] += chunk_offsets[chunk];
+                }
+            }
+
+            // Write the claimed vertices in the serial order
+            #pragma omp for schedule(dynamic, 1)
+            for (size_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                size_t position = chunk_offsets[chunk];
+                size_t end = head + (chunk + 1) * BFS_CHUNK;
+                for (size_t i = head + chunk * BFS_CHUNK; i < end && i < tail; ++i)
+                {
+                    uint64_t claim = stamp | (i - head);
+                    uint32_t vertex = queue[i];
+                    for (uint64_t j = offsets[vertex]; j < offsets[vertex + 1]; ++j)
+                    {
+                        uint32_t neighbor = neighbors[j];
+                        if (claims[neighbor] == claim
+                            && (j == offsets[vertex]
+                                || neighbor != neighbors[j - 1]))
+                        {
+                            marks[neighbor] = epoch;
+                            queue[position++] = neighbor;
+                        }
+                    }
+                }
+            }
+        }
+
+        size_t next_tail = chunk_offsets[chunks];
+        if (next_tail == tail)
+        {
+            break;
+        }
+
+        result.max_distance += 1;
+        head = tail;
+        tail = next_tail;
+    }
+
+    // Same as the last vertex of the serial sweep
+    result.last_vertex = queue[tail - 1];
+
+    return result;
+}
+
+static sweep_result_t direction_optimizing_sweep(bfs_t* bfs, uint32_t source)
+{
+    uint32_t vcount = bfs->graph->vcount;
+    const uint64_t* offsets = bfs->graph->offsets;
+    const uint32_t* neighbors = bfs->graph->neighbors;
+    uint32_t* queue = bfs->queue;
+    uint32_t* marks = bfs->marks;
+    uint64_t* frontier = bfs->frontier;
+    uint64_t* next = bfs->next;
+    size_t words = BITMAP_WORDS(vcount);
+    uint32_t epoch = next_epoch(bfs);
+
+    sweep_result_t result;
+    result.max_distance = 0;
+    result.last_vertex = source;
+
+    queue[0] = source;
+    marks[source] = epoch;
+
+    // The frontier is either queue[head, tail) or the frontier bitmap
+    bool bottom_up = false;
+    size_t head = 0;
+    size_t tail = 1;
+    uint64_t frontier_size = 1;
+    uint64_t frontier_edges = offsets[source + 1] - offsets[source];
+    uint64_t unexplored_edges = offsets[vcount] - frontier_edges;
+
+    while (frontier_size > 0)
+    {
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_ALPHA)
+        {
+            // Convert the queue to a bitmap
+            memset(frontier, 0, words * sizeof(uint64_t));
+            for (size_t i = head; i < tail; ++i)
+            {
+                frontier[queue[i] / 64] |= UINT64_C(1) << (queue[i] % 64);
+            }
+            bottom_up = true;
+        }
+        else if (bottom_up && frontier_size < vcount / BFS_BETA)
+        {
+            // Convert the bitmap to a queue
+            head = 0;
+            tail = 0;
+            for (size_t w = 0; w < words; ++w)
+            {
+                for (uint64_t bits = frontier[w]; bits; bits &= bits - 1)
+                {
+                    queue[tail++] = w * 64 + __builtin_ctzll(bits);
+                }
+            }
+            bottom_up = false;
+        }
+
+        uint32_t last_vertex = 0;
+        frontier_size = 0;
+        frontier_edges = 0;
+
+        if (bottom_up)
+        {
+            // Every unvisited vertex looks for a parent in the frontier
+            memset(next, 0, words * sizeof(uint64_t));
+            for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+            {
+                if (marks[vertex] == epoch)
+                {
+                    continue;
+                }
+
+                for (uint64_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+                {
+                    uint32_t neighbor = neighbors[i];
+                    if (frontier[neighbor / 64] & (UINT64_C(1) << (neighbor % 64)))
+                    {
+                        marks[vertex] = epoch;
+                        next[vertex / 64] |= UINT64_C(1) << (vertex % 64);
+                        last_vertex = vertex;
+                        frontier_size += 1;
+                        frontier_edges += offsets[vertex + 1] - offsets[vertex];
+                        break;
+                    }
+                }
+            }
+
+            uint64_t* swap = frontier;
+            frontier = next;
+            next = swap;
+        }
+        else
+        {
+            // Every frontier vertex pushes its unvisited neighbors
+            size_t level_end = tail;
+            for (; head < level_end; ++head)
+            {
+                uint32_t vertex = queue[head];
+                for (uint64_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+                {
+                    uint32_t neighbor = neighbors[i];
+                    if (marks[neighbor] != epoch)
+                    {
+                        marks[neighbor] = epoch;
+                        queue[tail++] = neighbor;
+                        frontier_edges += offsets[neighbor + 1]
+                            - offsets[neighbor];
+                    }
+                }
+            }
+
+            frontier_size = tail - head;
+            if (frontier_size > 0)
+            {
+                last_vertex = queue[tail - 1];
+            }
+        }
+
+        if (frontier_size > 0)
+        {
+            result.max_distance += 1;
+            result.last_vertex = last_vertex;
+            unexplored_edges -= frontier_edges;
+        }
+    }
+
+    return result;
+}
+
+sweep_result_t bfs_sweep(bfs_t* bfs, igraph_integer_t source)
+{
+    switch (bfs->engine)
+    {
+        case BFS_ENGINE_DIRECTION_OPTIMIZING:
+            return direction_optimizing_sweep(bfs, source);
+        case BFS_ENGINE_TOP_DOWN:
+        default:
+            if (bfs->threads > 1)
+            {
+                return parallel_top_down_sweep(bfs, source);
+            }
+            return top_down_sweep(bfs, source, NULL);
+    }
+}
+
+sweep_result_t bfs_levels(bfs_t* bfs, igraph_integer_t source, size_t* levels)
+{
+    return top_down_sweep(bfs, source, levels);
+}
+
+void bfs_multi_sweep(bfs_t* bfs, const uint32_t* sources, size_t count,
+    sweep_result_t* results)
+{
+    uint32_t vcount = bfs->graph->vcount;
+    const uint64_t* offsets = bfs->graph->offsets;
+    const uint32_t* neighbors = bfs->graph->neighbors;
+
+    if (!bfs->seen)
+    {
+        bfs->seen = malloc(vcount * sizeof(uint64_t));
+        bfs->visit = malloc(vcount * sizeof(uint64_t));
+        bfs->visit_next = malloc(vcount * sizeof(uint64_t));
+    }
+
+    uint64_t* seen = bfs->seen;
+    uint64_t* visit = bfs->visit;
+    uint64_t* visit_next = bfs->visit_next;
+
+    memset(seen, 0, vcount * sizeof(uint64_t));
+    memset(visit, 0, vcount * sizeof(uint64_t));
+    memset(visit_next, 0, vcount * sizeof(uint64_t));
+
+    // Each source owns a bit of the masks
+    for (size_t i = 0; i < count; ++i)
+    {
+        seen[sources[i]] |= UINT64_C(1) << i;
+        visit[sources[i]] |= UINT64_C(1) << i;
+        results[i].max_distance = 0;
+        results[i].last_vertex = sources[i];
+    }
+
+    igraph_integer_t distance = 0;
+    bool active = true;
+
+    while (active)
+    {
+        distance += 1;
+        active = false;
+
+        // Push the sources visiting each vertex to its neighbors
+        for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+        {
+            uint64_t mask = visit[vertex];
+            if (!mask)
+            {
+                continue;
+            }
+
+            for (uint64_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i)
+            {
+                visit_next[neighbors[i]] |= mask;
+            }
+        }
+
+        // Keep the sources reaching a vertex for the first time
+        for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+        {
+            uint64_t mask = visit_next[vertex] & ~seen[vertex];
+            visit_next[vertex] = 0;
+            visit[vertex] = mask;
+
+            if (!mask)
+            {
+                continue;
+            }
+
+            seen[vertex] |= mask;
+            active = true;
+
+            for (; mask; mask &= mask - 1)
+            {
+                sweep_result_t* result = &results[__builtin_ctzll(mask)];
+                result->max_distance = distance;
+                result->last_vertex = vertex;
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <igraph_datatype.h>
+
+#include "csr.h"
+
+// The number of sources of a multi-source breadth first search
+#define BFS_BATCH_SIZE 64
+
+typedef struct sweep_result
+{
+    igraph_integer_t max_distance;
+    igraph_integer_t last_vertex;
+} sweep_result_t;
+
+typedef enum bfs_engine
+{
+    // Queue based traversal, visiting the vertices in the same order as igraph
+    BFS_ENGINE_TOP_DOWN,
+
+    // Switch to a bottom-up expansion when the frontier is large (Beamer)
+    BFS_ENGINE_DIRECTION_OPTIMIZING,
+} bfs_engine_t;
+
+typedef struct bfs
+{
+    csr_t* graph;
+
+    // The engine used by bfs_sweep
+    bfs_engine_t engine;
+
+    // The number of threads of the top-down engine (serial if 1)
+    int threads;
+
+    // Parent claims and chunk offsets of the parallel levels (allocated on use)
+    uint64_t* claims;
+    size_t* chunk_offsets;
+    uint32_t stamp;
+
+    // Vertices in visit order
+    uint32_t* queue;
+
+    // A vertex is visited by the current traversal if its mark is the epoch,
+    // so that the marks never have to be cleared between traversals
+    uint32_t* marks;
+    uint32_t epoch;
+
+    // Frontier bitmaps of the bottom-up steps
+    uint64_t* frontier;
+    uint64_t* next;
+
+    // Whether the sweeps from many sources are batched with bfs_multi_sweep
+    bool batched;
+
+    // Per vertex source masks of the multi-source search (allocated on use)
+    uint64_t* seen;
+    uint64_t* visit;
+    uint64_t* visit_next;
+} bfs_t;
+
+/**
+ * @brief Initialize the buffers needed to traverse a graph (top-down engine)
+ * @param bfs The bfs to initialize
+ * @param graph The graph to traverse (must outlive the bfs)
+ */
+void init_bfs(bfs_t* bfs, csr_t* graph);
+
+/**
+ * @brief Destroy the buffers of a bfs
+ * @param bfs The bfs to destroy
+ */
+void destroy_bfs(bfs_t* bfs);
+
+/**
+ * @brief Run a breadth first search with the engine of the bfs
+ * @param bfs The bfs
+ * @param source The root of the search
+ * @return The eccentricity of the source and the last visited vertex
+ *         (with the direction optimizing engine, the eccentricity is the same
+ *         but the last vertex is the last one of the farthest level in the
+ *         order it was expanded, which is not always the top-down one)
+ */
+sweep_result_t bfs_sweep(bfs_t* bfs, igraph_integer_t source);
+
+/**
+ * @brief Run a serial top-down breadth first search and keep its levels
+ * @param bfs The bfs
+ * @param source The root of the search
+ * @param levels The vertices at distance d are bfs->queue[levels[d], levels[d + 1])
+ *               (out, at least eccentricity + 2 elements, vcount + 1 is always enough)
+ * @return The eccentricity of the source and the last visited vertex
+ */
+sweep_result_t bfs_levels(bfs_t* bfs, igraph_integer_t source, size_t* levels);
+
+/**
+ * @brief Run up to BFS_BATCH_SIZE breadth first searches at once, sharing
+ *        each adjacency scan between the sources (MS-BFS, Then et al.)
+ * @param bfs The bfs
+ * @param sources The roots of the searches
+ * @param count The number of sources (at most BFS_BATCH_SIZE)
+ * @param results The eccentricity of each source and a vertex at this
+ *                distance, the one with the highest id (out)
+ */
+void bfs_multi_sweep(bfs_t* bfs, const uint32_t* sources, size_t count,
+    sweep_result_t* results);
@@ -0,0 +1,111 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <igraph.h>
+
+#define MEMBERSHIP_MAGIC "VLGMEMB1"
+
+// The file is the header followed by the cluster of each vertex
+typedef struct membership_header
+{
+    char magic[8];
+    membership_key_t key;
+    uint64_t nb_clusters;
+} membership_header_t;
+
+bool load_membership(const char* path, membership_key_t* key,
+    igraph_vector_t* membership, igraph_integer_t* nb_clusters)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    struct stat st;
+    size_t size = sizeof(membership_header_t)
+        + key->vcount * sizeof(uint32_t);
+    if (fstat(fd, &st) == -1 || (size_t) st.st_size != size)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Check that it is the same graph and the same community detection
+    const membership_header_t* header = data;
+    bool found = memcmp(header->magic, MEMBERSHIP_MAGIC, 8) == 0
+        && memcmp(&header->key, key, sizeof(membership_key_t)) == 0
+        && header->nb_clusters <= key->vcount;
+
+    // A corrupted file is a miss, rather than clusters out of range
+    const uint32_t* clusters = (const uint32_t*) (header + 1);
+    for (uint64_t i = 0; found && i < key->vcount; ++i)
+    {
+        found = clusters[i] < header->nb_clusters;
+    }
+
+    if (found)
+    {
+        igraph_vector_init(membership, key->vcount);
+        for (uint64_t i = 0; i < key->vcount; ++i)
+        {
+            VECTOR(*membership)[i] = clusters[i];
+        }
+        *nb_clusters = header->nb_clusters;
+    }
+
+    munmap(data, size);
+    return found;
+}
+
+void save_membership(const char* path, membership_key_t* key,
+    igraph_vector_t* membership, igraph_integer_t nb_clusters)
+{
+    FILE* output = fopen(path, "wb");
+    if (!output)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    membership_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MEMBERSHIP_MAGIC, 8);
+    header.key = *key;
+    header.nb_clusters = nb_clusters;
+    bool written = fwrite(&header, sizeof(header), 1, output) == 1;
+
+    uint32_t* clusters = malloc(key->vcount * sizeof(uint32_t));
+    for (uint64_t i = 0; i < key->vcount; ++i)
+    {
+        clusters[i] = VECTOR(*membership)[i];
+    }
+    written = written
+        && fwrite(clusters, sizeof(uint32_t), key->vcount, output)
+            == key->vcount;
+    free(clusters);
+
+    // Remove a partial file, which a later run would only reject
+    if (fclose(output) != 0 || !written)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        unlink(path);
+    }
+}
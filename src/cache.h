@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <igraph_datatype.h>
+
+typedef struct membership_key
+{
+    uint64_t graph_hash;
+    uint64_t vcount;
+    uint32_t algorithm;
+    uint32_t padding;
+    double parameters[2];
+} membership_key_t;
+
+/**
+ * @brief Read the communities saved for a key
+ * @param path The cache file
+ * @param key The graph and the community detection
+ * @param membership The membership vector to initialize, if found
+ * @param nb_clusters The number of clusters, if found
+ * @return Whether the cache file exists, matches the key and holds valid
+ *         clusters
+ */
+bool load_membership(const char* path, membership_key_t* key,
+    igraph_vector_t* membership, igraph_integer_t* nb_clusters);
+
+/**
+ * @brief Save the communities for a key, replacing the cache file, which is
+ *        removed if it cannot be written whole
+ * @param path The cache file
+ * @param key The graph and the community detection
+ * @param membership The membership vector
+ * @param nb_clusters The number of clusters
+ */
+void save_membership(const char* path, membership_key_t* key,
+    igraph_vector_t* membership, igraph_integer_t nb_clusters);
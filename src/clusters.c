@@ -0,0 +1,51 @@
+#include "clusters.h"
+
+#include <stdlib.h>
+
+#include <igraph.h>
+
+void init_clusters(clusters_t* clusters, igraph_integer_t nb_clusters,
+    igraph_vector_t* membership)
+{
+    igraph_integer_t vcount = igraph_vector_size(membership);
+
+    clusters->nb_clusters = nb_clusters;
+    clusters->membership = malloc(vcount * sizeof(uint32_t));
+    clusters->offsets = calloc(nb_clusters + 1, sizeof(uint64_t));
+    clusters->vertices = malloc(vcount * sizeof(uint32_t));
+
+    // Count the vertices of each cluster
+    for (igraph_integer_t i = 0; i < vcount; ++i)
+    {
+        uint32_t cluster = VECTOR(*membership)[i];
+        clusters->membership[i] = cluster;
+        clusters->offsets[cluster + 1] += 1;
+    }
+
+    // Compute the offsets
+    for (igraph_integer_t c = 0; c < nb_clusters; ++c)
+    {
+        clusters->offsets[c + 1] += clusters->offsets[c];
+    }
+
+    // Scatter the vertices
+    uint64_t* positions = malloc(nb_clusters * sizeof(uint64_t));
+    for (igraph_integer_t c = 0; c < nb_clusters; ++c)
+    {
+        positions[c] = clusters->offsets[c];
+    }
+
+    for (igraph_integer_t i = 0; i < vcount; ++i)
+    {
+        clusters->vertices[positions[clusters->membership[i]]++] = i;
+    }
+
+    free(positions);
+}
+
+void destroy_clusters(clusters_t* clusters)
+{
+    free(clusters->vertices);
+    free(clusters->offsets);
+    free(clusters->membership);
+}
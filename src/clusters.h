@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <igraph_datatype.h>
+
+typedef struct clusters
+{
+    igraph_integer_t nb_clusters;
+
+    // The cluster of each vertex
+    uint32_t* membership;
+
+    // The vertices of the cluster c are vertices[offsets[c], offsets[c + 1]),
+    // in increasing order
+    uint64_t* offsets;
+    uint32_t* vertices;
+} clusters_t;
+
+/**
+ * @brief Index the vertices of each cluster (counting sort of the membership)
+ * @param clusters The clusters to initialize
+ * @param nb_clusters The number of clusters
+ * @param membership The membership of each vertex
+ */
+void init_clusters(clusters_t* clusters, igraph_integer_t nb_clusters,
+    igraph_vector_t* membership);
+
+/**
+ * @brief Destroy the clusters
+ * @param clusters The clusters to destroy
+ */
+void destroy_clusters(clusters_t* clusters);
+
+/**
+ * @brief Get the number of vertices of a cluster
+ * @param clusters The clusters
+ * @param cluster The cluster
+ * @return The number of vertices of the cluster
+ */
+static inline uint64_t cluster_size(clusters_t* clusters, uint32_t cluster)
+{
+    return clusters->offsets[cluster + 1] - clusters->offsets[cluster];
+}
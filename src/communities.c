@@ -1,8 +1,13 @@
 #include "communities.h"
 
 #include <igraph.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 
+#include "louvain.h"
+#include "options.h"
 #include "vector.h"
 
 igraph_integer_t compute_communities_louvain(igraph_t* graph,
@@ -48,3 +53,423 @@ igraph_integer_t compute_communities_leiden(igraph_t* graph,
 
     return nb_clusters;
 }
+
+// Take the vertices of highest degree (counting sort on the degrees), the
+// lowest ones first on ties
+static void degree_seeds(csr_t* graph, uint32_t* seeds, uint32_t nb_seeds)
+{
+    uint32_t vcount = graph->vcount;
+
+    uint64_t max_degree = 0;
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        if (csr_degree(graph, vertex) > max_degree)
+        {
+            max_degree = csr_degree(graph, vertex);
+        }
+    }
+
+    // The vertices of degree d come after the ones of higher degree
+    uint64_t* offsets = calloc(max_degree + 2, sizeof(uint64_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        offsets[max_degree - csr_degree(graph, vertex) + 1] += 1;
+    }
+    for (uint64_t d = 0; d <= max_degree; ++d)
+    {
+        offsets[d + 1] += offsets[d];
+    }
+
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        uint64_t position = offsets[max_degree - csr_degree(graph, vertex)]++;
+        if (position < nb_seeds)
+        {
+            seeds[position] = vertex;
+        }
+    }
+
+    free(offsets);
+}
+
+// Take the highest degree vertex, then the vertex farthest from the seeds
+// taken (the unreachable ones first), keeping the distances up to date with
+// a breadth first search from each new seed that stops at closer vertices,
+// return the number of seeds taken (fewer once every vertex is a seed)
+static uint32_t farthest_seeds(csr_t* graph, uint32_t* seeds,
+    uint32_t nb_seeds)
+{
+    uint32_t vcount = graph->vcount;
+
+    uint32_t* distances = malloc(vcount * sizeof(uint32_t));
+    uint32_t* queue = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        distances[vertex] = UINT32_MAX;
+    }
+
+    degree_seeds(graph, seeds, 1);
+
+    for (uint32_t i = 0; i < nb_seeds; ++i)
+    {
+        if (i > 0)
+        {
+            uint32_t farthest = 0;
+            for (uint32_t vertex = 1; vertex < vcount; ++vertex)
+            {
+                if (distances[vertex] > distances[farthest])
+                {
+                    farthest = vertex;
+                }
+            }
+
+            if (distances[farthest] == 0)
+            {
+                nb_seeds = i;
+                break;
+            }
+            seeds[i] = farthest;
+        }
+
+        size_t head = 0;
+        size_t tail = 0;
+        distances[seeds[i]] = 0;
+        queue[tail++] = seeds[i];
+
+        while (head < tail)
+        {
+            uint32_t vertex = queue[head++];
+            for (uint64_t j = graph->offsets[vertex];
+                 j < graph->offsets[vertex + 1]; ++j)
+            {
+                uint32_t neighbor = graph->neighbors[j];
+                if (distances[neighbor] > distances[vertex] + 1)
+                {
+                    distances[neighbor] = distances[vertex] + 1;
+                    queue[tail++] = neighbor;
+                }
+            }
+        }
+    }
+
+    free(queue);
+    free(distances);
+
+    return nb_seeds;
+}
+
+igraph_integer_t compute_communities_voronoi(csr_t* graph,
+    igraph_vector_t* membership, igraph_integer_t nb_seeds,
+    voronoi_seeding_t seeding)
+{
+    uint32_t vcount = graph->vcount;
+
+    if (nb_seeds <= 0)
+    {
+        nb_seeds = ceil(sqrt(vcount));
+    }
+    if ((uint32_t) nb_seeds > vcount)
+    {
+        nb_seeds = vcount;
+    }
+
+    // Choose the seeds
+    uint32_t* seeds = malloc((nb_seeds ? nb_seeds : 1) * sizeof(uint32_t));
+    if (seeding == VORONOI_SEEDING_FARTHEST)
+    {
+        nb_seeds = farthest_seeds(graph, seeds, nb_seeds);
+    }
+    else
+    {
+        degree_seeds(graph, seeds, nb_seeds);
+    }
+
+    // Grow all the seeds at once
+    uint32_t* cells = malloc(vcount * sizeof(uint32_t));
+    uint32_t* queue = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        cells[vertex] = UINT32_MAX;
+    }
+
+    uint32_t nb_clusters = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    for (igraph_integer_t i = 0; i < nb_seeds; ++i)
+    {
+        cells[seeds[i]] = nb_clusters++;
+        queue[tail++] = seeds[i];
+    }
+
+    uint32_t start = 0;
+    while (true)
+    {
+        while (head < tail)
+        {
+            uint32_t vertex = queue[head++];
+            for (uint64_t j = graph->offsets[vertex];
+                 j < graph->offsets[vertex + 1]; ++j)
+            {
+                uint32_t neighbor = graph->neighbors[j];
+                if (cells[neighbor] == UINT32_MAX)
+                {
+                    cells[neighbor] = cells[vertex];
+                    queue[tail++] = neighbor;
+                }
+            }
+        }
+
+        // A vertex left alone seeds its connected component
+        while (start < vcount && cells[start] != UINT32_MAX)
+        {
+            start += 1;
+        }
+
+        if (start == vcount)
+        {
+            break;
+        }
+
+        cells[start] = nb_clusters++;
+        queue[tail++] = start;
+    }
+
+    igraph_vector_init(membership, vcount);
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        VECTOR(*membership)[vertex] = cells[vertex];
+    }
+
+    free(queue);
+    free(cells);
+    free(seeds);
+
+    return nb_clusters;
+}
+
+// The vertices given at once to a thread by the label propagation
+#define LABEL_PROPAGATION_CHUNK 1024
+
+// The maximum number of rounds of the label propagation
+#define LABEL_PROPAGATION_MAX_ROUNDS 100
+
+static int compare_labels(const void* lhs, const void* rhs)
+{
+    uint32_t left = *(const uint32_t*) lhs;
+    uint32_t right = *(const uint32_t*) rhs;
+    return (left > right) - (left < right);
+}
+
+// Break the ties between labels like a random choice per vertex, the lowest
+// label would flood the graph
+static inline uint32_t label_priority(uint32_t label, uint32_t vertex)
+{
+    uint32_t hash = (label ^ (vertex * 2654435761u)) * 2246822519u;
+    return hash ^ (hash >> 13);
+}
+
+// Get the most frequent label of the neighbors, the current one on ties, or
+// else the one of highest priority
+static uint32_t most_frequent_label(csr_t* graph, uint32_t* labels,
+    uint32_t* buffer, uint32_t vertex, uint32_t current)
+{
+    size_t size = 0;
+    for (uint64_t i = graph->offsets[vertex];
+         i < graph->offsets[vertex + 1]; ++i)
+    {
+        uint32_t neighbor = graph->neighbors[i];
+        if (neighbor != vertex)
+        {
+            #pragma omp atomic read
+            buffer[size] = labels[neighbor];
+            size += 1;
+        }
+    }
+
+    if (size == 0)
+    {
+        return current;
+    }
+
+    qsort(buffer, size, sizeof(uint32_t), compare_labels);
+
+    uint32_t best = current;
+    size_t best_count = 0;
+    size_t start = 0;
+    for (size_t i = 1; i <= size; ++i)
+    {
+        if (i == size || buffer[i] != buffer[start])
+        {
+            size_t count = i - start;
+            uint32_t label = buffer[start];
+            if (count > best_count
+                || (count == best_count && best != current
+                    && (label == current || label_priority(label, vertex)
+                        > label_priority(best, vertex))))
+            {
+                best = label;
+                best_count = count;
+            }
+            start = i;
+        }
+    }
+
+    return best;
+}
+
+igraph_integer_t compute_communities_label_propagation(csr_t* graph,
+    igraph_vector_t* membership, double cutoff, int threads)
+{
+    uint32_t vcount = graph->vcount;
+
+    uint64_t max_degree = 0;
+    uint32_t* labels = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        labels[vertex] = vertex;
+        if (csr_degree(graph, vertex) > max_degree)
+        {
+            max_degree = csr_degree(graph, vertex);
+        }
+    }
+
+    for (int round = 0; round < LABEL_PROPAGATION_MAX_ROUNDS; ++round)
+    {
+        uint64_t changes = 0;
+
+        // The labels are updated in place, the next vertices see them
+        #pragma omp parallel num_threads(threads) reduction(+: changes)
+        {
+            uint32_t* buffer = malloc((max_degree ? max_degree : 1)
+                * sizeof(uint32_t));
+
+            #pragma omp for schedule(dynamic, LABEL_PROPAGATION_CHUNK)
+            for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+            {
+                uint32_t current;
+                #pragma omp atomic read
+                current = labels[vertex];
+
+                uint32_t label = most_frequent_label(graph, labels, buffer,
+                    vertex, current);
+                if (label != current)
+                {
+                    #pragma omp atomic write
+                    labels[vertex] = label;
+                    changes += 1;
+                }
+            }
+
+            free(buffer);
+        }
+
+        if (changes < cutoff * vcount)
+        {
+            break;
+        }
+    }
+
+    // Renumber the labels from 0, in increasing order
+    uint32_t* ids = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t label = 0; label < vcount; ++label)
+    {
+        ids[label] = UINT32_MAX;
+    }
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        ids[labels[vertex]] = 0;
+    }
+
+    uint32_t nb_clusters = 0;
+    for (uint32_t label = 0; label < vcount; ++label)
+    {
+        if (ids[label] != UINT32_MAX)
+        {
+            ids[label] = nb_clusters++;
+        }
+    }
+
+    igraph_vector_init(membership, vcount);
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        VECTOR(*membership)[vertex] = ids[labels[vertex]];
+    }
+
+    free(ids);
+    free(labels);
+
+    return nb_clusters;
+}
+
+igraph_integer_t compute_communities(igraph_t* graph, bfs_t* bfs,
+    options_t* options, igraph_vector_t* membership, bool verbose)
+{
+    igraph_integer_t nb_clusters;
+
+    switch (options->community_algorithm)
+    {
+        case COMMUNITY_ALGORITHM_LOUVAIN:
+            // Compute the communities using louvain
+            if (verbose)
+            {
+                fprintf(stderr, "Running Louvain\n");
+            }
+            nb_clusters = compute_communities_louvain(graph, membership);
+            break;
+        case COMMUNITY_ALGORITHM_PARALLEL_LOUVAIN:
+            // Compute the communities using louvain on the csr
+            if (verbose)
+            {
+                fprintf(stderr, "Running parallel Louvain (threads: %d)\n",
+                        bfs->threads);
+            }
+            nb_clusters = compute_communities_parallel_louvain(bfs->graph,
+                membership, bfs->threads);
+            break;
+        case COMMUNITY_ALGORITHM_VORONOI:
+            // Compute the communities around seeds
+            if (verbose)
+            {
+                fprintf(stderr, "Running Voronoi (seeding: %s)\n",
+                        options->voronoi_seeding == VORONOI_SEEDING_FARTHEST
+                            ? "farthest" : "degree");
+            }
+            nb_clusters = compute_communities_voronoi(bfs->graph, membership,
+                options->voronoi_seeds, options->voronoi_seeding);
+            break;
+        case COMMUNITY_ALGORITHM_LABEL_PROPAGATION:
+            // Compute the communities by label propagation
+            if (verbose)
+            {
+                fprintf(stderr, "Running label propagation (cutoff: %f, "
+                                "threads: %d)\n",
+                        options->label_propagation_cutoff, bfs->threads);
+            }
+            nb_clusters = compute_communities_label_propagation(bfs->graph,
+                membership, options->label_propagation_cutoff, bfs->threads);
+            break;
+        case COMMUNITY_ALGORITHM_LEIDEN:
+        default:
+        {
+            // Compute the communities using leiden
+            igraph_integer_t ecount = igraph_ecount(graph);
+            igraph_real_t resolution = 1.0 / (2.0 * ecount);
+            igraph_real_t beta = 0.01;
+
+            if (verbose)
+            {
+                fprintf(stderr, "Running Leiden (resolution: %f, beta: %f)\n",
+                        resolution, beta);
+            }
+
+            nb_clusters = compute_communities_leiden(
+                    graph,
+                    membership,
+                    resolution,
+                    beta);
+            break;
+        }
+    }
+
+    return nb_clusters;
+}
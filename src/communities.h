@@ -1,7 +1,38 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include <igraph_datatype.h>
 
+#include "bfs.h"
+#include "csr.h"
+
+typedef enum community_algorithm
+{
+    // Leiden (igraph)
+    COMMUNITY_ALGORITHM_LEIDEN,
+    // Louvain (igraph multilevel)
+    COMMUNITY_ALGORITHM_LOUVAIN,
+    // Louvain with parallel rounds of moves on the CSR
+    COMMUNITY_ALGORITHM_PARALLEL_LOUVAIN,
+    // The closest seed of each vertex (multi-source breadth first search)
+    COMMUNITY_ALGORITHM_VORONOI,
+    // The most frequent label around each vertex, until few labels change
+    COMMUNITY_ALGORITHM_LABEL_PROPAGATION,
+} community_algorithm_t;
+
+// Stop the label propagation once less than this fraction of the labels
+// change in a round
+#define LABEL_PROPAGATION_DEFAULT_CUTOFF 0.001
+
+typedef enum voronoi_seeding
+{
+    // The vertices of highest degree
+    VORONOI_SEEDING_DEGREE,
+    // The highest degree vertex, then the vertex farthest from the seeds
+    VORONOI_SEEDING_FARTHEST,
+} voronoi_seeding_t;
+
 /**
  * @brief Compute the communities using Louvain
  * @param graph The graph
@@ -21,3 +52,52 @@ igraph_integer_t compute_communities_louvain(igraph_t* graph,
  */
 igraph_integer_t compute_communities_leiden(igraph_t* graph,
     igraph_vector_t* membership, igraph_real_t resolution, igraph_real_t beta);
+
+/**
+ * @brief Compute the communities as the Voronoi cells of some seeds: one
+ *        breadth first search from all the seeds at once gives each vertex
+ *        to its closest seed (the first one on ties)
+ * @param graph The graph
+ * @param membership The membership of each vertex (out)
+ * @param nb_seeds The number of seeds (0 for the square root of the number
+ *                 of vertices), a vertex unreachable from the seeds becomes
+ *                 the seed of its connected component
+ * @param seeding How the seeds are chosen
+ * @return The number of clusters
+ */
+igraph_integer_t compute_communities_voronoi(csr_t* graph,
+    igraph_vector_t* membership, igraph_integer_t nb_seeds,
+    voronoi_seeding_t seeding);
+
+/**
+ * @brief Compute the communities using label propagation: each vertex takes
+ *        the most frequent label of its neighbors (its own on ties, or else
+ *        a hashed choice), in place and in parallel over chunks of vertices,
+ *        so the result depends on the scheduling with more than one thread
+ * @param graph The graph
+ * @param membership The membership of each vertex, the labels renumbered
+ *                   from 0 (out)
+ * @param cutoff Stop once less than this fraction of the labels change in a
+ *               round
+ * @param threads The number of threads
+ * @return The number of clusters
+ */
+igraph_integer_t compute_communities_label_propagation(csr_t* graph,
+    igraph_vector_t* membership, double cutoff, int threads);
+
+// Defined in options.h, which needs the algorithms above
+typedef struct options options_t;
+
+/**
+ * @brief Compute the communities with the algorithm of the options, and its
+ *        parameters
+ * @param graph The graph (for Leiden and Louvain)
+ * @param bfs The bfs over the csr of the graph, with the number of threads
+ *            (for the other algorithms)
+ * @param options The options
+ * @param membership The membership of each vertex (out)
+ * @param verbose Print the algorithm and its parameters
+ * @return The number of clusters
+ */
+igraph_integer_t compute_communities(igraph_t* graph, bfs_t* bfs,
+    options_t* options, igraph_vector_t* membership, bool verbose);
@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "csr.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <igraph.h>
+
+void init_csr(csr_t* csr, igraph_t* graph)
+{
+    igraph_integer_t vcount = igraph_vcount(graph);
+    igraph_integer_t ecount = igraph_ecount(graph);
+
+    csr->vcount = vcount;
+    csr->mapping = NULL;
+    csr->mapping_size = 0;
+    csr->offsets = calloc(vcount + 1, sizeof(uint64_t));
+    csr->neighbors = malloc(2 * (size_t) ecount * sizeof(uint32_t));
+
+    // Compute the degrees
+    for (igraph_integer_t e = 0; e < ecount; ++e)
+    {
+        csr->offsets[IGRAPH_FROM(graph, e) + 1] += 1;
+        csr->offsets[IGRAPH_TO(graph, e) + 1] += 1;
+    }
+
+    // Compute the offsets
+    for (igraph_integer_t i = 0; i < vcount; ++i)
+    {
+        csr->offsets[i + 1] += csr->offsets[i];
+    }
+
+    // Scatter the edges in edge order
+    uint64_t* positions = malloc((vcount + 1) * sizeof(uint64_t));
+    uint32_t* unsorted = malloc(2 * (size_t) ecount * sizeof(uint32_t));
+
+    memcpy(positions, csr->offsets, (vcount + 1) * sizeof(uint64_t));
+    for (igraph_integer_t e = 0; e < ecount; ++e)
+    {
+        uint32_t from = IGRAPH_FROM(graph, e);
+        uint32_t to = IGRAPH_TO(graph, e);
+        unsorted[positions[from]++] = to;
+        unsorted[positions[to]++] = from;
+    }
+
+    // Transpose to sort the neighbors (the adjacency is symmetric, so
+    // scattering each row in vertex order yields sorted rows)
+    memcpy(positions, csr->offsets, (vcount + 1) * sizeof(uint64_t));
+    for (igraph_integer_t i = 0; i < vcount; ++i)
+    {
+        for (uint64_t j = csr->offsets[i]; j < csr->offsets[i + 1]; ++j)
+        {
+            csr->neighbors[positions[unsorted[j]]++] = i;
+        }
+    }
+
+    free(unsorted);
+    free(positions);
+}
+
+void init_induced_csr(csr_t* csr, csr_t* graph, const uint32_t* vertices,
+    size_t count, const uint32_t* membership, const uint32_t* local)
+{
+    csr->vcount = count;
+    csr->mapping = NULL;
+    csr->mapping_size = 0;
+    csr->offsets = malloc((count + 1) * sizeof(uint64_t));
+
+    // Count the edges inside the cluster
+    uint32_t cluster = membership[vertices[0]];
+    uint64_t edges = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        csr->offsets[i] = edges;
+        for (uint64_t j = graph->offsets[vertices[i]];
+             j < graph->offsets[vertices[i] + 1]; ++j)
+        {
+            edges += membership[graph->neighbors[j]] == cluster;
+        }
+    }
+    csr->offsets[count] = edges;
+
+    // Copy them with the local indices (they stay sorted since the vertices
+    // of the cluster are in increasing order)
+    csr->neighbors = malloc((edges ? edges : 1) * sizeof(uint32_t));
+    uint64_t position = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (uint64_t j = graph->offsets[vertices[i]];
+             j < graph->offsets[vertices[i] + 1]; ++j)
+        {
+            uint32_t neighbor = graph->neighbors[j];
+            if (membership[neighbor] == cluster)
+            {
+                csr->neighbors[position++] = local[neighbor];
+            }
+        }
+    }
+}
+
+void csr_graph(csr_t* csr, igraph_t* graph)
+{
+    igraph_vector_t edges;
+    igraph_vector_init(&edges, csr->offsets[csr->vcount]);
+
+    // Take each edge from its lowest end, and each loop (twice in its row)
+    // once
+    igraph_integer_t size = 0;
+    for (igraph_integer_t i = 0; i < csr->vcount; ++i)
+    {
+        bool loop = false;
+        for (uint64_t j = csr->offsets[i]; j < csr->offsets[i + 1]; ++j)
+        {
+            igraph_integer_t neighbor = csr->neighbors[j];
+            if (neighbor == i)
+            {
+                loop = !loop;
+            }
+            if (neighbor > i || (neighbor == i && loop))
+            {
+                VECTOR(edges)[size++] = i;
+                VECTOR(edges)[size++] = neighbor;
+            }
+        }
+    }
+    igraph_vector_resize(&edges, size);
+
+    igraph_create(graph, &edges, csr->vcount, IGRAPH_UNDIRECTED);
+    igraph_vector_destroy(&edges);
+}
+
+void destroy_csr(csr_t* csr)
+{
+    if (csr->mapping)
+    {
+        munmap(csr->mapping, csr->mapping_size);
+        return;
+    }
+
+    free(csr->neighbors);
+    free(csr->offsets);
+}
+
+static inline uint64_t hash_mix(uint64_t hash, uint64_t word)
+{
+    hash ^= word;
+    hash *= 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 29);
+}
+
+uint64_t csr_hash(csr_t* csr)
+{
+    uint64_t hash = hash_mix(0, csr->vcount);
+
+    // Hash the offsets, then the neighbors two at a time
+    for (igraph_integer_t i = 0; i <= csr->vcount; ++i)
+    {
+        hash = hash_mix(hash, csr->offsets[i]);
+    }
+
+    uint64_t count = csr->offsets[csr->vcount];
+    uint64_t j = 0;
+    for (; j + 1 < count; j += 2)
+    {
+        hash = hash_mix(hash, (uint64_t) csr->neighbors[j] << 32
+            | csr->neighbors[j + 1]);
+    }
+    if (j < count)
+    {
+        hash = hash_mix(hash, csr->neighbors[j]);
+    }
+
+    return hash;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <igraph_datatype.h>
+
+typedef struct csr
+{
+    igraph_integer_t vcount;
+    uint64_t* offsets;
+    uint32_t* neighbors;
+
+    // The mapped file holding the offsets and the neighbors, if any
+    void* mapping;
+    size_t mapping_size;
+} csr_t;
+
+/**
+ * @brief Build the compressed sparse row representation of an undirected graph
+ *        (the neighbors of each vertex are sorted, as with igraph_neighbors)
+ * @param csr The csr to initialize
+ * @param graph The graph
+ */
+void init_csr(csr_t* csr, igraph_t* graph);
+
+/**
+ * @brief Build the subgraph induced by the vertices of a cluster, with the
+ *        vertex i being the ith vertex of the cluster
+ * @param csr The csr to initialize
+ * @param graph The graph
+ * @param vertices The vertices of the cluster, in increasing order
+ * @param count The number of vertices of the cluster
+ * @param membership The cluster of each vertex of the graph
+ * @param local The index of each vertex of the graph in its cluster
+ */
+void init_induced_csr(csr_t* csr, csr_t* graph, const uint32_t* vertices,
+    size_t count, const uint32_t* membership, const uint32_t* local);
+
+/**
+ * @brief Build the igraph graph of a csr (each edge once, from its lowest end)
+ * @param csr The csr
+ * @param graph The graph to initialize
+ */
+void csr_graph(csr_t* csr, igraph_t* graph);
+
+/**
+ * @brief Destroy a csr (unmapping its file, if mapped)
+ * @param csr The csr to destroy
+ */
+void destroy_csr(csr_t* csr);
+
+/**
+ * @brief Get the degree of a vertex
+ * @param csr The csr
+ * @param vertex The vertex
+ * @return The number of neighbors of the vertex
+ */
+static inline uint64_t csr_degree(csr_t* csr, uint32_t vertex)
+{
+    return csr->offsets[vertex + 1] - csr->offsets[vertex];
+}
+
+/**
+ * @brief Hash the content of a csr (the offsets and the neighbors), to
+ *        recognize the same graph between runs
+ * @param csr The csr
+ * @return The 64 bits hash
+ */
+uint64_t csr_hash(csr_t* csr);
@@ -0,0 +1,319 @@
+#include "diameter.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <igraph.h>
+
+igraph_integer_t community_center(bfs_t* bfs, clusters_t* clusters,
+    igraph_integer_t community)
+{
+    csr_t* graph = bfs->graph;
+
+    igraph_integer_t center = -1;
+    uint64_t center_degree = 0;
+
+    for (uint64_t i = clusters->offsets[community];
+         i < clusters->offsets[community + 1]; ++i)
+    {
+        uint32_t vertex = clusters->vertices[i];
+        if (center == -1 || csr_degree(graph, vertex) > center_degree)
+        {
+            center = vertex;
+            center_degree = csr_degree(graph, vertex);
+        }
+    }
+
+    return center;
+}
+
+void shortest_path(bfs_t* bfs, igraph_integer_t from, igraph_integer_t to,
+    igraph_vector_t* path)
+{
+    csr_t* graph = bfs->graph;
+    igraph_integer_t vcount = graph->vcount;
+
+    // Get the distances from the source
+    size_t* levels = malloc((vcount + 1) * sizeof(size_t));
+    uint32_t* distances = malloc(vcount * sizeof(uint32_t));
+    sweep_result_t stats = bfs_levels(bfs, from, levels);
+
+    // No path to a target in another component
+    if (bfs->marks[to] != bfs->epoch)
+    {
+        igraph_vector_clear(path);
+        free(distances);
+        free(levels);
+        return;
+    }
+
+    for (igraph_integer_t d = 0; d <= stats.max_distance; ++d)
+    {
+        for (size_t i = levels[d]; i < levels[d + 1]; ++i)
+        {
+            distances[bfs->queue[i]] = d;
+        }
+    }
+
+    // Walk back from the target, one level at a time
+    uint32_t vertex = to;
+    igraph_vector_resize(path, distances[to] + 1);
+    VECTOR(*path)[distances[to]] = to;
+    while (distances[vertex] > 0)
+    {
+        for (uint64_t i = graph->offsets[vertex];
+             i < graph->offsets[vertex + 1]; ++i)
+        {
+            uint32_t neighbor = graph->neighbors[i];
+            if (bfs->marks[neighbor] == bfs->epoch
+                && distances[neighbor] + 1 == distances[vertex])
+            {
+                vertex = neighbor;
+                break;
+            }
+        }
+        VECTOR(*path)[distances[vertex]] = vertex;
+    }
+
+    free(distances);
+    free(levels);
+}
+
+igraph_integer_t ifub_diameter(bfs_t* bfs, igraph_integer_t root,
+    igraph_integer_t lower_bound, igraph_integer_t* from, igraph_integer_t* to,
+    igraph_integer_t* bfs_count)
+{
+    igraph_integer_t vcount = bfs->graph->vcount;
+
+    // Compute the fringe of the root, the next sweeps overwrite the queue
+    size_t* levels = malloc((vcount + 1) * sizeof(size_t));
+    sweep_result_t stats = bfs_levels(bfs, root, levels);
+
+    size_t visited = levels[stats.max_distance + 1];
+    uint32_t* fringe = malloc(visited * sizeof(uint32_t));
+    memcpy(fringe, bfs->queue, visited * sizeof(uint32_t));
+
+    igraph_integer_t count = 1;
+    igraph_integer_t lower = stats.max_distance;
+    igraph_integer_t upper = 2 * stats.max_distance;
+    igraph_integer_t lower_from = root;
+    igraph_integer_t lower_to = stats.last_vertex;
+
+    // A longer known path (from a previous sweep) prunes the fringe earlier,
+    // if it lies in the component just searched
+    if (lower_bound > lower && bfs->marks[*from] == bfs->epoch)
+    {
+        lower = lower_bound;
+        lower_from = *from;
+        lower_to = *to;
+    }
+
+    // The vertices of the level i have an eccentricity of at most
+    // max(lower, 2 * i), so the diameter is found once lower > 2 * (i - 1)
+    for (igraph_integer_t i = stats.max_distance; i > 0 && lower < upper; --i)
+    {
+        for (size_t j = levels[i]; j < levels[i + 1] && lower < upper; ++j)
+        {
+            stats = bfs_sweep(bfs, fringe[j]);
+            count += 1;
+
+            if (stats.max_distance > lower)
+            {
+                lower = stats.max_distance;
+                lower_from = fringe[j];
+                lower_to = stats.last_vertex;
+            }
+        }
+
+        if (lower > 2 * (i - 1))
+        {
+            break;
+        }
+
+        upper = 2 * (i - 1);
+    }
+
+    free(fringe);
+    free(levels);
+
+    if (from)
+    {
+        *from = lower_from;
+    }
+
+    if (to)
+    {
+        *to = lower_to;
+    }
+
+    if (bfs_count)
+    {
+        *bfs_count = count;
+    }
+
+    return lower;
+}
+
+void bounding_diameters(bfs_t* bfs, igraph_integer_t max_bfs, bounds_t* bounds)
+{
+    csr_t* graph = bfs->graph;
+    igraph_integer_t vcount = graph->vcount;
+
+    uint32_t* lower = calloc(vcount, sizeof(uint32_t));
+    uint32_t* upper = malloc(vcount * sizeof(uint32_t));
+    size_t* levels = malloc((vcount + 1) * sizeof(size_t));
+
+    // The vertices still able to change the bounds
+    uint32_t* candidates = malloc(vcount * sizeof(uint32_t));
+    size_t candidates_count = 0;
+
+    // The vertices of the component
+    uint32_t* component = malloc(vcount * sizeof(uint32_t));
+    size_t component_count = 0;
+
+    bounds->diameter_lower = 0;
+    bounds->diameter_upper = INT_MAX;
+    bounds->radius_lower = 0;
+    bounds->radius_upper = INT_MAX;
+    bounds->center = -1;
+    bounds->bfs_count = 0;
+
+    // Start from the vertex with the highest degree
+    igraph_integer_t source = 0;
+    for (igraph_integer_t i = 1; i < vcount; ++i)
+    {
+        if (csr_degree(graph, i) > csr_degree(graph, source))
+        {
+            source = i;
+        }
+    }
+
+    bool pick_upper = false;
+
+    while (vcount > 0 && (max_bfs == 0 || bounds->bfs_count < max_bfs))
+    {
+        sweep_result_t stats = bfs_levels(bfs, source, levels);
+        igraph_integer_t eccentricity = stats.max_distance;
+        bounds->bfs_count += 1;
+
+        if (bounds->bfs_count == 1)
+        {
+            // Restrict everything to the component of the first source
+            component_count = levels[eccentricity + 1];
+            memcpy(component, bfs->queue, component_count * sizeof(uint32_t));
+            memcpy(candidates, bfs->queue, component_count * sizeof(uint32_t));
+            candidates_count = component_count;
+
+            for (size_t i = 0; i < component_count; ++i)
+            {
+                upper[component[i]] = UINT32_MAX;
+            }
+        }
+
+        // Bound the eccentricities with the distances to the source
+        for (igraph_integer_t d = 0; d <= eccentricity; ++d)
+        {
+            uint32_t far = eccentricity - d > d ? eccentricity - d : d;
+            for (size_t i = levels[d]; i < levels[d + 1]; ++i)
+            {
+                uint32_t vertex = bfs->queue[i];
+                if (far > lower[vertex])
+                {
+                    lower[vertex] = far;
+                }
+                if ((uint32_t) (eccentricity + d) < upper[vertex])
+                {
+                    upper[vertex] = eccentricity + d;
+                }
+            }
+        }
+
+        // Update the global bounds
+        bounds->diameter_lower = 0;
+        bounds->diameter_upper = 0;
+        bounds->radius_lower = INT_MAX;
+        for (size_t i = 0; i < component_count; ++i)
+        {
+            uint32_t vertex = component[i];
+            if ((igraph_integer_t) lower[vertex] > bounds->diameter_lower)
+            {
+                bounds->diameter_lower = lower[vertex];
+            }
+            if ((igraph_integer_t) upper[vertex] > bounds->diameter_upper)
+            {
+                bounds->diameter_upper = upper[vertex];
+            }
+            if ((igraph_integer_t) lower[vertex] < bounds->radius_lower)
+            {
+                bounds->radius_lower = lower[vertex];
+            }
+
+            // Any vertex bounds the radius with its upper bound (the source
+            // with its eccentricity), including the ones dropped as exact
+            if ((igraph_integer_t) upper[vertex] < bounds->radius_upper)
+            {
+                bounds->radius_upper = upper[vertex];
+                bounds->center = vertex;
+            }
+        }
+
+        if (bounds->diameter_lower == bounds->diameter_upper
+            && bounds->radius_lower == bounds->radius_upper)
+        {
+            break;
+        }
+
+        // Drop the candidates which are known exactly, or which can neither
+        // raise the diameter nor lower the radius (once no candidate is left,
+        // both intervals are closed)
+        size_t kept = 0;
+        for (size_t i = 0; i < candidates_count; ++i)
+        {
+            uint32_t vertex = candidates[i];
+            igraph_integer_t vertex_lower = lower[vertex];
+            igraph_integer_t vertex_upper = upper[vertex];
+
+            bool diameter_useless = vertex_upper <= bounds->diameter_lower
+                && 2 * vertex_lower >= bounds->diameter_upper;
+            bool radius_useless = vertex_lower >= bounds->radius_upper;
+
+            if (vertex_lower != vertex_upper
+                && !(diameter_useless && radius_useless))
+            {
+                candidates[kept++] = vertex;
+            }
+        }
+        candidates_count = kept;
+
+        if (candidates_count == 0)
+        {
+            break;
+        }
+
+        // Alternate between the highest upper and the lowest lower bound,
+        // taking the highest degree on ties
+        source = candidates[0];
+        for (size_t i = 1; i < candidates_count; ++i)
+        {
+            uint32_t vertex = candidates[i];
+            uint32_t key = pick_upper ? upper[vertex] : lower[vertex];
+            uint32_t best = pick_upper ? upper[source] : lower[source];
+
+            if ((pick_upper ? key > best : key < best)
+                || (key == best
+                    && csr_degree(graph, vertex) > csr_degree(graph, source)))
+            {
+                source = vertex;
+            }
+        }
+        pick_upper = !pick_upper;
+    }
+
+    free(component);
+    free(candidates);
+    free(levels);
+    free(upper);
+    free(lower);
+}
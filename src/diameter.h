@@ -0,0 +1,71 @@
+#pragma once
+
+#include <igraph_datatype.h>
+
+#include "bfs.h"
+#include "clusters.h"
+
+typedef struct bounds
+{
+    igraph_integer_t diameter_lower;
+    igraph_integer_t diameter_upper;
+    igraph_integer_t radius_lower;
+    igraph_integer_t radius_upper;
+
+    // A vertex with an eccentricity of at most radius_upper
+    igraph_integer_t center;
+
+    igraph_integer_t bfs_count;
+} bounds_t;
+
+/**
+ * @brief Get the vertex with the highest degree in a community
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
+ * @param community The community
+ * @return The vertex with the highest degree (the first one on ties)
+ */
+igraph_integer_t community_center(bfs_t* bfs, clusters_t* clusters,
+    igraph_integer_t community);
+
+/**
+ * @brief Get a shortest path between two vertices
+ * @param bfs The bfs over the graph
+ * @param from The source of the path
+ * @param to The target of the path
+ * @param path The vertices along the path, from the source, empty if the
+ *             target is not connected to the source (out, initialized)
+ */
+void shortest_path(bfs_t* bfs, igraph_integer_t from, igraph_integer_t to,
+    igraph_vector_t* path);
+
+/**
+ * @brief Compute the exact diameter using iFUB (Crescenzi et al.): the
+ *        eccentricities of the fringe of a breadth first search are computed
+ *        from the farthest level down, until the lower bound meets the upper bound
+ * @param bfs The bfs over the graph
+ * @param root The root of the fringe (a central vertex needs less sweeps)
+ * @param lower_bound The distance between *from and *to when known (0 if
+ *                    none, ignored outside the component of the root)
+ * @param from One end of a diametral path (in/out, can be NULL without a
+ *             lower bound)
+ * @param to The other end of the diametral path (in/out, can be NULL without
+ *           a lower bound)
+ * @param bfs_count The number of breadth first searches done (out, can be NULL)
+ * @return The diameter of the connected component of the root
+ */
+igraph_integer_t ifub_diameter(bfs_t* bfs, igraph_integer_t root,
+    igraph_integer_t lower_bound, igraph_integer_t* from, igraph_integer_t* to,
+    igraph_integer_t* bfs_count);
+
+/**
+ * @brief Bound the diameter and the radius using BoundingDiameters (Takes,
+ *        Kosters): each breadth first search tightens the eccentricity bounds
+ *        of every vertex, and the vertices whose bounds cannot change the
+ *        diameter nor the radius anymore are not used as sources
+ * @param bfs The bfs over the graph
+ * @param max_bfs The maximum number of breadth first searches (0 for no limit)
+ * @param bounds The bounds of the connected component of the highest degree
+ *               vertex (out, exact if the lower and upper bounds are equal)
+ */
+void bounding_diameters(bfs_t* bfs, igraph_integer_t max_bfs, bounds_t* bounds);
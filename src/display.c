@@ -194,3 +194,30 @@ void write_graph_dot_node_colored(igraph_t* graph, igraph_vector_t* weights,
     write_graph_dot_node_colored_edges(graph, weights, output);
     fprintf(output, "}\n");
 }
+
+void write_graph_dot_weighted(igraph_t* graph, igraph_vector_t* sizes,
+    igraph_vector_t* diameters, igraph_vector_t* weights, FILE* output)
+{
+    fprintf(output, "/* Created manually */\n");
+    fprintf(output, "graph {\n");
+
+    // Label the vertices with their size and diameter
+    igraph_integer_t vcount = igraph_vcount(graph);
+    for (igraph_integer_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        fprintf(output, "    %d [label=\"%d\\nsize: %d\\ndiameter: %d\"];\n",
+            vertex, vertex, (igraph_integer_t) VECTOR(*sizes)[vertex],
+            (igraph_integer_t) VECTOR(*diameters)[vertex]);
+    }
+
+    // Label the edges with their weight
+    igraph_integer_t ecount = igraph_ecount(graph);
+    for (igraph_integer_t edge = 0; edge < ecount; ++edge)
+    {
+        fprintf(output, "    %d -- %d [label=\"%d\"];\n",
+            IGRAPH_FROM(graph, edge), IGRAPH_TO(graph, edge),
+            (igraph_integer_t) VECTOR(*weights)[edge]);
+    }
+
+    fprintf(output, "}\n");
+}
@@ -27,3 +27,14 @@ void write_graph_dot_clustered(igraph_t* graph, FILE* output,
  */
 void write_graph_dot_node_colored(igraph_t* graph, igraph_vector_t* weights,
     FILE* output);
+
+/**
+ * @brief Write the graph as dot with labeled vertices and edges
+ * @param graph The graph
+ * @param sizes The size of each vertex
+ * @param diameters The diameter of each vertex
+ * @param weights The weight of each edge
+ * @param output The output
+ */
+void write_graph_dot_weighted(igraph_t* graph, igraph_vector_t* sizes,
+    igraph_vector_t* diameters, igraph_vector_t* weights, FILE* output);
@@ -4,8 +4,11 @@
 #include <string.h>
 
 #include <igraph.h>
+#include <omp.h>
 
+#include "csr.h"
 #include "display.h"
+#include "loader.h"
 #include "vector.h"
 
 igraph_integer_t compute_components(igraph_t* graph, igraph_vector_t* membership,
@@ -32,7 +35,7 @@ igraph_integer_t compute_components(igraph_t* graph, igraph_vector_t* membership
 }
 
 void write_clean_graph(igraph_t* graph, igraph_vector_t* membership,
-    igraph_integer_t component)
+    igraph_integer_t component, bool binary)
 {
     igraph_integer_t vcount = igraph_vcount(graph);
     igraph_integer_t ecount = igraph_ecount(graph);
@@ -55,6 +58,10 @@ void write_clean_graph(igraph_t* graph, igraph_vector_t* membership,
     vector_int_fprint(stderr, &lut);
     fprintf(stderr, "\n");*/
 
+    // The edges of the component, for the binary csr
+    igraph_vector_t edges;
+    igraph_vector_init(&edges, 0);
+
     // Initialize the selector
     igraph_es_t selector;
     igraph_es_all(&selector, IGRAPH_EDGEORDER_ID);
@@ -76,8 +83,16 @@ void write_clean_graph(igraph_t* graph, igraph_vector_t* membership,
 
         if (component_from == component && component_to == component)
         {
-            fprintf(stdout, "%d %d\n", (igraph_integer_t)VECTOR(lut)[from],
-                (igraph_integer_t)VECTOR(lut)[to]);
+            if (binary)
+            {
+                igraph_vector_push_back(&edges, VECTOR(lut)[from]);
+                igraph_vector_push_back(&edges, VECTOR(lut)[to]);
+            }
+            else
+            {
+                fprintf(stdout, "%d %d\n", (igraph_integer_t)VECTOR(lut)[from],
+                    (igraph_integer_t)VECTOR(lut)[to]);
+            }
         }
 
         e++;
@@ -98,19 +113,49 @@ void write_clean_graph(igraph_t* graph, igraph_vector_t* membership,
     // Destroy the selector
     igraph_es_destroy(&selector);
 
+    if (binary)
+    {
+        // Keep the original id of each vertex of the component
+        igraph_vector_t ids;
+        igraph_vector_init(&ids, current_index);
+        for (igraph_integer_t i = 0; i < vcount; ++i)
+        {
+            if (VECTOR(lut)[i] != -1)
+            {
+                VECTOR(ids)[(igraph_integer_t) VECTOR(lut)[i]] = i;
+            }
+        }
+
+        // Write the component as a binary csr on stdout
+        igraph_t clean;
+        igraph_create(&clean, &edges, current_index, IGRAPH_UNDIRECTED);
+        csr_t csr;
+        init_csr(&csr, &clean);
+        write_csr_binary(stdout, &csr, &ids);
+        destroy_csr(&csr);
+        igraph_destroy(&clean);
+        igraph_vector_destroy(&ids);
+    }
+
+    // Destroy the edges
+    igraph_vector_destroy(&edges);
+
     // Destroy the lut
     igraph_vector_destroy(&lut);
 }
 
 int main(int argc, char** argv)
 {
-    if (argc != 2)
+    bool binary = argc == 3 && strcmp(argv[1], "--binary") == 0;
+    if (argc != 2 && !binary)
     {
-        fprintf(stderr, "Usage: %s [graph]\n", argv[0]);
+        fprintf(stderr, "Usage: %s [--binary] [graph]\n", argv[0]);
+        fprintf(stderr, "The largest component is printed on stdout, as an edge list or with --binary as a binary csr.\n");
         return 1;
     }
+    char* path = argv[argc - 1];
 
-    FILE* input = fopen(argv[1], "r");
+    FILE* input = fopen(path, "r");
     if (!input)
     {
         fprintf(stderr, "%s\n", strerror(errno));
@@ -118,10 +163,13 @@ int main(int argc, char** argv)
 
     igraph_t graph;
     // Create a new graph
-    igraph_read_graph_edgelist(&graph, input, 0, false);
+    if (!read_edgelist(input, &graph, omp_get_num_procs()))
+    {
+        return 1;
+    }
 
     // Display basic graph information
-    graph_information(argv[1], &graph);
+    graph_information(path, &graph);
 
     // Simplify the graph
     igraph_simplify(&graph, true, true, NULL);
@@ -134,7 +182,7 @@ int main(int argc, char** argv)
     igraph_integer_t largest = igraph_vector_which_max(&cluster_sizes);
 
     // Compute the cluster graph
-    write_clean_graph(&graph, &membership, largest);
+    write_clean_graph(&graph, &membership, largest, binary);
 
     // Destroy the components
     igraph_vector_destroy(&cluster_sizes);
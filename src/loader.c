@@ -0,0 +1,340 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "loader.h"
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <igraph.h>
+#include <omp.h>
+
+#define CSR_BINARY_MAGIC "VLGC"
+#define CSR_BINARY_IDS 1
+
+typedef struct csr_header
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t vcount;
+    uint64_t nb_neighbors;
+    uint64_t flags;
+} csr_header_t;
+
+static size_t line_start(const char* data, size_t size, size_t position)
+{
+    // Move to the start of the next line, so that no number is split
+    while (position > 0 && position < size && data[position - 1] != '\n')
+    {
+        ++position;
+    }
+    return position < size ? position : size;
+}
+
+static uint32_t* parse_integers(const char* begin, const char* end,
+    size_t* count, bool* valid)
+{
+    size_t capacity = (end - begin) / 8 + 16;
+    uint32_t* integers = malloc(capacity * sizeof(uint32_t));
+    size_t size = 0;
+
+    // Each line holds an edge, or nothing
+    int line_size = 0;
+    bool line_valid = true;
+
+    const char* current = begin;
+    while (current < end)
+    {
+        // Skip the separators, checking the line at its end
+        if (isspace((unsigned char) *current))
+        {
+            if (*current == '\n')
+            {
+                line_valid = line_size == 0 || line_size == 2;
+                line_size = 0;
+                if (!line_valid)
+                {
+                    break;
+                }
+            }
+            ++current;
+            continue;
+        }
+
+        // Stop at anything else than a number
+        if (*current < '0' || *current > '9')
+        {
+            #pragma omp atomic write
+            *valid = false;
+            break;
+        }
+
+        // A vertex id is an igraph_integer_t, stop on larger numbers
+        uint64_t value = 0;
+        while (current < end && *current >= '0' && *current <= '9'
+               && value <= INT32_MAX)
+        {
+            value = value * 10 + (*current - '0');
+            ++current;
+        }
+        if (value > INT32_MAX)
+        {
+            #pragma omp atomic write
+            *valid = false;
+            break;
+        }
+
+        if (size == capacity)
+        {
+            capacity *= 2;
+            integers = realloc(integers, capacity * sizeof(uint32_t));
+        }
+        integers[size++] = value;
+        line_size += 1;
+    }
+
+    // The last line of the part may not end with a newline
+    if (!line_valid || (line_size != 0 && line_size != 2))
+    {
+        #pragma omp atomic write
+        *valid = false;
+    }
+
+    *count = size;
+    return integers;
+}
+
+bool read_edgelist(FILE* input, igraph_t* graph, int threads)
+{
+    // Only regular files can be mapped
+    struct stat st;
+    if (fstat(fileno(input), &st) == -1 || !S_ISREG(st.st_mode)
+        || st.st_size == 0)
+    {
+        return igraph_read_graph_edgelist(graph, input, 0, false)
+            == IGRAPH_SUCCESS;
+    }
+
+    size_t size = st.st_size;
+    const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE,
+        fileno(input), 0);
+    if (data == MAP_FAILED)
+    {
+        return igraph_read_graph_edgelist(graph, input, 0, false)
+            == IGRAPH_SUCCESS;
+    }
+    posix_madvise((void*) data, size, POSIX_MADV_SEQUENTIAL);
+
+    uint32_t** chunks = malloc(threads * sizeof(uint32_t*));
+    size_t* offsets = calloc(threads + 1, sizeof(size_t));
+    igraph_vector_t edges;
+    size_t nb_integers = 0;
+    bool valid = true;
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int thread = omp_get_thread_num();
+        int nb_threads = omp_get_num_threads();
+
+        // Parse the lines of this part of the file
+        size_t begin = line_start(data, size, size / nb_threads * thread);
+        size_t end = thread + 1 == nb_threads ? size
+            : line_start(data, size, size / nb_threads * (thread + 1));
+        chunks[thread] = parse_integers(data + begin, data + end,
+            &offsets[thread + 1], &valid);
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            // The parts are concatenated in file order
+            for (int i = 0; i < nb_threads; ++i)
+            {
+                offsets[i + 1] += offsets[i];
+            }
+            nb_integers = offsets[nb_threads];
+            igraph_vector_init(&edges, nb_integers);
+        }
+
+        for (size_t i = 0; i < offsets[thread + 1] - offsets[thread]; ++i)
+        {
+            VECTOR(edges)[offsets[thread] + i] = chunks[thread][i];
+        }
+        free(chunks[thread]);
+    }
+
+    // Every edge has two ends
+    valid = valid && nb_integers % 2 == 0;
+
+    munmap((void*) data, size);
+    free(offsets);
+    free(chunks);
+
+    if (valid)
+    {
+        igraph_create(graph, &edges, 0, IGRAPH_UNDIRECTED);
+    }
+    else
+    {
+        fprintf(stderr, "Invalid edge list: expected \"u v\" lines, with ids "
+                        "up to %d\n", INT32_MAX);
+    }
+    igraph_vector_destroy(&edges);
+
+    return valid;
+}
+
+// Whether the file is a regular file starting with the binary csr magic
+static bool is_csr_binary(FILE* input, csr_header_t* header)
+{
+    int fd = fileno(input);
+    struct stat st;
+    return fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+        && pread(fd, header, sizeof(csr_header_t), 0) == sizeof(csr_header_t)
+        && memcmp(header->magic, CSR_BINARY_MAGIC, 4) == 0;
+}
+
+// Whether the offsets are sorted from 0 to the number of neighbors, and the
+// neighbors are vertices, so that no traversal reads out of the arrays
+static bool check_csr(csr_t* csr, uint64_t nb_neighbors)
+{
+    if (csr->offsets[0] != 0 || csr->offsets[csr->vcount] != nb_neighbors)
+    {
+        return false;
+    }
+    for (igraph_integer_t i = 0; i < csr->vcount; ++i)
+    {
+        if (csr->offsets[i] > csr->offsets[i + 1])
+        {
+            return false;
+        }
+    }
+    for (uint64_t i = 0; i < nb_neighbors; ++i)
+    {
+        if (csr->neighbors[i] >= (uint64_t) csr->vcount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool map_csr_binary(FILE* input, csr_header_t* header, csr_t* csr)
+{
+    int fd = fileno(input);
+    struct stat st;
+    fstat(fd, &st);
+
+    // The sizes are checked before they are multiplied, to not overflow
+    size_t size = 0;
+    bool valid = header->version == CSR_BINARY_VERSION
+        && header->vcount <= INT32_MAX
+        && header->nb_neighbors <= (uint64_t) st.st_size / sizeof(uint32_t);
+    if (valid)
+    {
+        size = sizeof(csr_header_t)
+            + (header->vcount + 1) * sizeof(uint64_t)
+            + header->nb_neighbors * sizeof(uint32_t)
+            + (header->flags & CSR_BINARY_IDS
+                ? header->vcount * sizeof(uint32_t) : 0);
+        valid = (size_t) st.st_size == size;
+    }
+
+    char* data = valid
+        ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (data != MAP_FAILED)
+    {
+        // The arrays are used in place
+        csr->vcount = header->vcount;
+        csr->offsets = (uint64_t*) (data + sizeof(csr_header_t));
+        csr->neighbors = (uint32_t*) (csr->offsets + header->vcount + 1);
+        csr->mapping = data;
+        csr->mapping_size = size;
+
+        if (check_csr(csr, header->nb_neighbors))
+        {
+            return true;
+        }
+        munmap(data, size);
+    }
+
+    fprintf(stderr, "Invalid binary csr: version %u, %llu vertices, "
+                    "%llu neighbors, %zu bytes\n", header->version,
+            (unsigned long long) header->vcount,
+            (unsigned long long) header->nb_neighbors, (size_t) st.st_size);
+    return false;
+}
+
+bool load_graph(FILE* input, igraph_t* graph, csr_t* csr, int threads)
+{
+    csr_header_t header;
+    csr_t mapped;
+    if (is_csr_binary(input, &header))
+    {
+        if (!map_csr_binary(input, &header, &mapped))
+        {
+            return false;
+        }
+
+        // Build the graph from the mapped csr, with no parsing
+        if (graph)
+        {
+            csr_graph(&mapped, graph);
+        }
+        if (csr)
+        {
+            *csr = mapped;
+        }
+        else
+        {
+            destroy_csr(&mapped);
+        }
+        return true;
+    }
+
+    // The csr of an edge list is built from a graph, kept only if asked for
+    igraph_t parsed;
+    if (!read_edgelist(input, graph ? graph : &parsed, threads))
+    {
+        return false;
+    }
+    if (csr)
+    {
+        init_csr(csr, graph ? graph : &parsed);
+    }
+    if (!graph)
+    {
+        igraph_destroy(&parsed);
+    }
+    return true;
+}
+
+void write_csr_binary(FILE* output, csr_t* csr, igraph_vector_t* ids)
+{
+    csr_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CSR_BINARY_MAGIC, 4);
+    header.version = CSR_BINARY_VERSION;
+    header.vcount = csr->vcount;
+    header.nb_neighbors = csr->offsets[csr->vcount];
+    header.flags = ids ? CSR_BINARY_IDS : 0;
+
+    fwrite(&header, sizeof(header), 1, output);
+    fwrite(csr->offsets, sizeof(uint64_t), csr->vcount + 1, output);
+    fwrite(csr->neighbors, sizeof(uint32_t), header.nb_neighbors, output);
+
+    if (ids)
+    {
+        uint32_t* original = malloc(csr->vcount * sizeof(uint32_t));
+        for (igraph_integer_t i = 0; i < csr->vcount; ++i)
+        {
+            original[i] = VECTOR(*ids)[i];
+        }
+        fwrite(original, sizeof(uint32_t), csr->vcount, output);
+        free(original);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <igraph_datatype.h>
+
+#include "csr.h"
+
+// The version of the binary csr format written by write_csr_binary
+#define CSR_BINARY_VERSION 1
+
+/**
+ * @brief Read an undirected graph from an edge list ("u v" per line), like
+ *        igraph_read_graph_edgelist, mapping the file in memory and parsing
+ *        it with several threads (pipes and the standard input fall back to
+ *        igraph_read_graph_edgelist)
+ * @param input The file
+ * @param graph The graph to initialize
+ * @param threads The number of threads
+ * @return Whether the file is a valid edge list (else the graph is not
+ *         initialized)
+ */
+bool read_edgelist(FILE* input, igraph_t* graph, int threads);
+
+/**
+ * @brief Read a graph, by mapping a binary csr file in memory (see
+ *        write_csr_binary), or else from an edge list with read_edgelist
+ * @param input The file
+ * @param graph The graph to initialize, or NULL if only the csr is needed
+ *        (a binary csr file is then only mapped)
+ * @param csr The csr to initialize (the mapped file for a binary csr file),
+ *        or NULL (if the graph is not)
+ * @param threads The number of threads
+ * @return Whether the file is a valid graph (else nothing is initialized)
+ */
+bool load_graph(FILE* input, igraph_t* graph, csr_t* csr, int threads);
+
+/**
+ * @brief Write a binary csr file: a header, the 64 bits offsets, the 32 bits
+ *        neighbors and optionally the original id of each vertex, in the
+ *        byte order of the machine
+ * @param output The file
+ * @param csr The csr
+ * @param ids The original id of each vertex, or NULL
+ */
+void write_csr_binary(FILE* output, csr_t* csr, igraph_vector_t* ids);
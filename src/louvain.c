@@ -0,0 +1,692 @@
+#include "louvain.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <igraph.h>
+#include <omp.h>
+
+// Stop moving the vertices of a level once a round improves the modularity
+// by less than this
+#define LOUVAIN_MIN_GAIN 1e-4
+
+// The maximum number of rounds on a level
+#define LOUVAIN_MAX_ROUNDS 64
+
+#define EMPTY_SLOT UINT32_MAX
+
+typedef struct louvain_graph
+{
+    uint32_t vcount;
+    uint64_t* offsets;
+    uint32_t* neighbors;
+    // The weight of each edge (NULL for unit weights)
+    uint64_t* weights;
+    // Twice the weight of the edges merged inside each vertex (NULL for none)
+    uint64_t* loops;
+    // Whether the arrays belong to the graph
+    bool owned;
+} louvain_graph_t;
+
+// The weight from a vertex to each community, in the order the communities
+// were met (open addressing)
+typedef struct community_map
+{
+    size_t capacity;
+    uint32_t* keys;
+    uint64_t* values;
+    // The slots used, in insertion order
+    uint32_t* slots;
+    size_t count;
+} community_map_t;
+
+static void destroy_louvain_graph(louvain_graph_t* graph)
+{
+    if (graph->owned)
+    {
+        free(graph->loops);
+        free(graph->weights);
+        free(graph->neighbors);
+        free(graph->offsets);
+    }
+}
+
+static void init_community_map(community_map_t* map)
+{
+    map->capacity = 0;
+    map->keys = NULL;
+    map->values = NULL;
+    map->slots = NULL;
+    map->count = 0;
+}
+
+static void destroy_community_map(community_map_t* map)
+{
+    free(map->slots);
+    free(map->values);
+    free(map->keys);
+}
+
+// Empty the map, with room for size communities
+static void reset_community_map(community_map_t* map, size_t size)
+{
+    size_t capacity = map->capacity ? map->capacity : 16;
+    while (capacity < 2 * size)
+    {
+        capacity *= 2;
+    }
+
+    if (capacity != map->capacity)
+    {
+        destroy_community_map(map);
+        map->capacity = capacity;
+        map->keys = malloc(capacity * sizeof(uint32_t));
+        map->values = malloc(capacity * sizeof(uint64_t));
+        map->slots = malloc(capacity * sizeof(uint32_t));
+        memset(map->keys, 0xFF, capacity * sizeof(uint32_t));
+    }
+    else
+    {
+        // Only clear the slots used
+        for (size_t i = 0; i < map->count; ++i)
+        {
+            map->keys[map->slots[i]] = EMPTY_SLOT;
+        }
+    }
+
+    map->count = 0;
+}
+
+static inline size_t find_slot(community_map_t* map, uint32_t community)
+{
+    size_t mask = map->capacity - 1;
+    size_t slot = (community * 2654435761u) & mask;
+    while (map->keys[slot] != EMPTY_SLOT && map->keys[slot] != community)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static inline void add_weight(community_map_t* map, uint32_t community,
+    uint64_t weight)
+{
+    size_t slot = find_slot(map, community);
+    if (map->keys[slot] == EMPTY_SLOT)
+    {
+        map->keys[slot] = community;
+        map->values[slot] = 0;
+        map->slots[map->count++] = slot;
+    }
+    map->values[slot] += weight;
+}
+
+static inline uint64_t get_weight(community_map_t* map, uint32_t community)
+{
+    size_t slot = find_slot(map, community);
+    return map->keys[slot] == EMPTY_SLOT ? 0 : map->values[slot];
+}
+
+static inline uint64_t edge_weight(louvain_graph_t* graph, uint64_t edge)
+{
+    return graph->weights ? graph->weights[edge] : 1;
+}
+
+// Compute the weight of each community, return the modularity
+static double community_totals(louvain_graph_t* graph, uint64_t* degrees,
+    uint64_t total, uint32_t* communities, uint64_t* totals, int threads)
+{
+    uint32_t vcount = graph->vcount;
+    memset(totals, 0, vcount * sizeof(uint64_t));
+
+    // The sums are on integers, they do not depend on the order
+    uint64_t inside = 0;
+    #pragma omp parallel for num_threads(threads) schedule(dynamic, 1024) \
+        reduction(+: inside)
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        uint32_t community = communities[vertex];
+
+        #pragma omp atomic
+        totals[community] += degrees[vertex];
+
+        inside += graph->loops ? graph->loops[vertex] : 0;
+        for (uint64_t i = graph->offsets[vertex];
+             i < graph->offsets[vertex + 1]; ++i)
+        {
+            if (communities[graph->neighbors[i]] == community)
+            {
+                inside += edge_weight(graph, i);
+            }
+        }
+    }
+
+    double squares = 0;
+    for (uint32_t community = 0; community < vcount; ++community)
+    {
+        squares += (double) totals[community] * totals[community];
+    }
+
+    return inside / (double) total - squares / ((double) total * total);
+}
+
+static inline uint32_t vertex_priority(uint32_t vertex)
+{
+    uint32_t hash = vertex * 2654435761u;
+    return hash ^ (hash >> 16);
+}
+
+// Whether a vertex comes before its uncolored neighbors
+static bool is_local_maximum(louvain_graph_t* graph, uint32_t* colors,
+    uint32_t vertex)
+{
+    uint32_t priority = vertex_priority(vertex);
+
+    for (uint64_t i = graph->offsets[vertex];
+         i < graph->offsets[vertex + 1]; ++i)
+    {
+        uint32_t neighbor = graph->neighbors[i];
+        uint32_t other = vertex_priority(neighbor);
+        if (neighbor != vertex && colors[neighbor] == EMPTY_SLOT
+            && (other > priority || (other == priority && neighbor > vertex)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Color the vertices so that no neighbors share a color (Jones, Plassmann):
+// the uncolored vertices coming before their uncolored neighbors take the
+// lowest color free around them, return the number of colors
+static uint32_t color_vertices(louvain_graph_t* graph, uint32_t* colors,
+    int threads)
+{
+    uint32_t vcount = graph->vcount;
+
+    uint64_t max_degree = 0;
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        uint64_t degree = graph->offsets[vertex + 1] - graph->offsets[vertex];
+        if (degree > max_degree)
+        {
+            max_degree = degree;
+        }
+    }
+
+    uint32_t* pending = malloc(vcount * sizeof(uint32_t));
+    bool* selected = malloc(vcount * sizeof(bool));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        pending[vertex] = vertex;
+        colors[vertex] = EMPTY_SLOT;
+    }
+
+    uint32_t nb_pending = vcount;
+    uint32_t nb_colors = 0;
+
+    while (nb_pending > 0)
+    {
+        // Select before coloring, so that the selection sees the colors of
+        // the previous step only
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 256)
+        for (uint32_t i = 0; i < nb_pending; ++i)
+        {
+            selected[i] = is_local_maximum(graph, colors, pending[i]);
+        }
+
+        // The selected vertices are not neighbors
+        #pragma omp parallel num_threads(threads)
+        {
+            bool* used = calloc(max_degree + 1, sizeof(bool));
+
+            #pragma omp for schedule(dynamic, 256)
+            for (uint32_t i = 0; i < nb_pending; ++i)
+            {
+                if (!selected[i])
+                {
+                    continue;
+                }
+
+                uint32_t vertex = pending[i];
+                for (uint64_t j = graph->offsets[vertex];
+                     j < graph->offsets[vertex + 1]; ++j)
+                {
+                    uint32_t color = colors[graph->neighbors[j]];
+                    if (color <= max_degree)
+                    {
+                        used[color] = true;
+                    }
+                }
+
+                uint32_t color = 0;
+                while (used[color])
+                {
+                    color += 1;
+                }
+                colors[vertex] = color;
+
+                for (uint64_t j = graph->offsets[vertex];
+                     j < graph->offsets[vertex + 1]; ++j)
+                {
+                    uint32_t neighbor_color = colors[graph->neighbors[j]];
+                    if (neighbor_color <= max_degree)
+                    {
+                        used[neighbor_color] = false;
+                    }
+                }
+            }
+
+            free(used);
+        }
+
+        // Keep the uncolored vertices
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < nb_pending; ++i)
+        {
+            uint32_t vertex = pending[i];
+            if (colors[vertex] == EMPTY_SLOT)
+            {
+                pending[kept++] = vertex;
+            }
+            else if (colors[vertex] + 1 > nb_colors)
+            {
+                nb_colors = colors[vertex] + 1;
+            }
+        }
+        nb_pending = kept;
+    }
+
+    free(selected);
+    free(pending);
+
+    return nb_colors;
+}
+
+// Get the neighboring community of best modularity gain for a vertex
+static uint32_t best_community(louvain_graph_t* graph, uint64_t* degrees,
+    uint64_t total, uint32_t* communities, uint64_t* totals,
+    community_map_t* map, uint32_t vertex)
+{
+    uint32_t current = communities[vertex];
+
+    // Sum the weights to the neighboring communities
+    uint64_t degree = graph->offsets[vertex + 1] - graph->offsets[vertex];
+    reset_community_map(map, degree < graph->vcount ? degree : graph->vcount);
+    for (uint64_t i = graph->offsets[vertex];
+         i < graph->offsets[vertex + 1]; ++i)
+    {
+        uint32_t neighbor = graph->neighbors[i];
+        if (neighbor != vertex)
+        {
+            add_weight(map, communities[neighbor], edge_weight(graph, i));
+        }
+    }
+
+    // The gain of joining a community, up to a constant, is the weight to
+    // it minus the weight expected from its total
+    double scale = degrees[vertex] / (double) total;
+    uint32_t best = current;
+    double best_gain = get_weight(map, current)
+        - scale * (totals[current] - degrees[vertex]);
+
+    for (size_t i = 0; i < map->count; ++i)
+    {
+        uint32_t community = map->keys[map->slots[i]];
+        if (community == current)
+        {
+            continue;
+        }
+
+        double gain = map->values[map->slots[i]] - scale * totals[community];
+        if (gain > best_gain
+            || (gain == best_gain && best != current && community < best))
+        {
+            best = community;
+            best_gain = gain;
+        }
+    }
+
+    return best;
+}
+
+// Move the vertices from their own community while the modularity improves,
+// one color at a time so that no neighbors move at once, return the
+// community of each vertex
+static uint32_t* move_vertices(louvain_graph_t* graph, uint64_t* degrees,
+    uint64_t total, community_map_t* maps, int threads)
+{
+    uint32_t vcount = graph->vcount;
+
+    // Sort the vertices by color
+    uint32_t* colors = malloc(vcount * sizeof(uint32_t));
+    uint32_t nb_colors = color_vertices(graph, colors, threads);
+
+    uint64_t* color_offsets = calloc(nb_colors + 1, sizeof(uint64_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        color_offsets[colors[vertex] + 1] += 1;
+    }
+    for (uint32_t color = 0; color < nb_colors; ++color)
+    {
+        color_offsets[color + 1] += color_offsets[color];
+    }
+
+    uint32_t* ordered = malloc(vcount * sizeof(uint32_t));
+    uint64_t* positions = malloc(nb_colors * sizeof(uint64_t));
+    memcpy(positions, color_offsets, nb_colors * sizeof(uint64_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        ordered[positions[colors[vertex]]++] = vertex;
+    }
+
+    uint32_t* communities = malloc(vcount * sizeof(uint32_t));
+    uint32_t* targets = malloc(vcount * sizeof(uint32_t));
+    uint64_t* totals = malloc(vcount * sizeof(uint64_t));
+
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        communities[vertex] = vertex;
+    }
+    double modularity = community_totals(graph, degrees, total, communities,
+        totals, threads);
+
+    for (int round = 0; round < LOUVAIN_MAX_ROUNDS; ++round)
+    {
+        #pragma omp parallel num_threads(threads)
+        {
+            community_map_t* map = &maps[omp_get_thread_num()];
+
+            for (uint32_t color = 0; color < nb_colors; ++color)
+            {
+                // The vertices of a color choose given the same communities
+                #pragma omp for schedule(dynamic, 256)
+                for (uint64_t i = color_offsets[color];
+                     i < color_offsets[color + 1]; ++i)
+                {
+                    targets[i] = best_community(graph, degrees, total,
+                        communities, totals, map, ordered[i]);
+                }
+
+                #pragma omp for schedule(static)
+                for (uint64_t i = color_offsets[color];
+                     i < color_offsets[color + 1]; ++i)
+                {
+                    uint32_t vertex = ordered[i];
+                    uint32_t community = communities[vertex];
+                    if (targets[i] != community)
+                    {
+                        communities[vertex] = targets[i];
+
+                        #pragma omp atomic
+                        totals[community] -= degrees[vertex];
+                        #pragma omp atomic
+                        totals[targets[i]] += degrees[vertex];
+                    }
+                }
+            }
+        }
+
+        double next_modularity = community_totals(graph, degrees, total,
+            communities, totals, threads);
+        double gain = next_modularity - modularity;
+        modularity = next_modularity;
+
+        if (gain < LOUVAIN_MIN_GAIN)
+        {
+            break;
+        }
+    }
+
+    free(totals);
+    free(targets);
+    free(positions);
+    free(ordered);
+    free(color_offsets);
+    free(colors);
+
+    return communities;
+}
+
+// Renumber the communities from 0, in increasing order, return their number
+static uint32_t compact_communities(uint32_t* communities, uint32_t vcount,
+    int threads)
+{
+    uint32_t* ids = malloc(vcount * sizeof(uint32_t));
+    memset(ids, 0xFF, vcount * sizeof(uint32_t));
+
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        ids[communities[vertex]] = 0;
+    }
+
+    uint32_t count = 0;
+    for (uint32_t community = 0; community < vcount; ++community)
+    {
+        if (ids[community] != EMPTY_SLOT)
+        {
+            ids[community] = count++;
+        }
+    }
+
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        communities[vertex] = ids[communities[vertex]];
+    }
+
+    free(ids);
+
+    return count;
+}
+
+// Merge the vertices of each community into a vertex of the result
+static void aggregate(louvain_graph_t* graph, uint32_t* communities,
+    uint32_t nb_communities, community_map_t* maps, int threads,
+    louvain_graph_t* result)
+{
+    uint32_t vcount = graph->vcount;
+
+    // Sort the vertices by community
+    uint64_t* member_offsets = calloc(nb_communities + 1, sizeof(uint64_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        member_offsets[communities[vertex] + 1] += 1;
+    }
+    for (uint32_t community = 0; community < nb_communities; ++community)
+    {
+        member_offsets[community + 1] += member_offsets[community];
+    }
+
+    uint64_t* positions = malloc(nb_communities * sizeof(uint64_t));
+    memcpy(positions, member_offsets, nb_communities * sizeof(uint64_t));
+    uint32_t* members = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        members[positions[communities[vertex]]++] = vertex;
+    }
+
+    result->vcount = nb_communities;
+    result->offsets = calloc(nb_communities + 1, sizeof(uint64_t));
+    result->neighbors = NULL;
+    result->weights = NULL;
+    result->loops = calloc(nb_communities, sizeof(uint64_t));
+    result->owned = true;
+
+    // Count the neighboring communities, then write them
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+        {
+            for (uint32_t community = 0; community < nb_communities;
+                 ++community)
+            {
+                result->offsets[community + 1] += result->offsets[community];
+            }
+
+            uint64_t size = result->offsets[nb_communities];
+            result->neighbors = malloc((size ? size : 1) * sizeof(uint32_t));
+            result->weights = malloc((size ? size : 1) * sizeof(uint64_t));
+        }
+
+        #pragma omp parallel num_threads(threads)
+        {
+            community_map_t* map = &maps[omp_get_thread_num()];
+
+            #pragma omp for schedule(dynamic, 64)
+            for (uint32_t community = 0; community < nb_communities;
+                 ++community)
+            {
+                uint64_t degree = 0;
+                for (uint64_t j = member_offsets[community];
+                     j < member_offsets[community + 1]; ++j)
+                {
+                    degree += graph->offsets[members[j] + 1]
+                        - graph->offsets[members[j]];
+                }
+                reset_community_map(map,
+                    degree < nb_communities ? degree : nb_communities);
+
+                uint64_t loop = 0;
+                for (uint64_t j = member_offsets[community];
+                     j < member_offsets[community + 1]; ++j)
+                {
+                    uint32_t vertex = members[j];
+                    loop += graph->loops ? graph->loops[vertex] : 0;
+
+                    for (uint64_t i = graph->offsets[vertex];
+                         i < graph->offsets[vertex + 1]; ++i)
+                    {
+                        uint32_t other = communities[graph->neighbors[i]];
+                        if (other == community)
+                        {
+                            loop += edge_weight(graph, i);
+                        }
+                        else
+                        {
+                            add_weight(map, other, edge_weight(graph, i));
+                        }
+                    }
+                }
+
+                if (pass == 0)
+                {
+                    result->offsets[community + 1] = map->count;
+                    result->loops[community] = loop;
+                }
+                else
+                {
+                    uint64_t offset = result->offsets[community];
+                    for (size_t i = 0; i < map->count; ++i)
+                    {
+                        result->neighbors[offset + i] =
+                            map->keys[map->slots[i]];
+                        result->weights[offset + i] =
+                            map->values[map->slots[i]];
+                    }
+                }
+            }
+        }
+    }
+
+    free(members);
+    free(positions);
+    free(member_offsets);
+}
+
+igraph_integer_t compute_communities_parallel_louvain(csr_t* graph,
+    igraph_vector_t* membership, int threads)
+{
+    uint32_t vcount = graph->vcount;
+    uint64_t total = graph->offsets[vcount];
+
+    louvain_graph_t level;
+    level.vcount = vcount;
+    level.offsets = graph->offsets;
+    level.neighbors = graph->neighbors;
+    level.weights = NULL;
+    level.loops = NULL;
+    level.owned = false;
+
+    community_map_t* maps = malloc(threads * sizeof(community_map_t));
+    for (int thread = 0; thread < threads; ++thread)
+    {
+        init_community_map(&maps[thread]);
+    }
+
+    // The community of each vertex of the graph at the current level
+    uint32_t* vertex_communities = malloc(vcount * sizeof(uint32_t));
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        vertex_communities[vertex] = vertex;
+    }
+    uint32_t nb_communities = vcount;
+
+    // Without edges, every vertex stays alone
+    while (total > 0)
+    {
+        // Compute the weighted degrees
+        uint64_t* degrees = malloc(level.vcount * sizeof(uint64_t));
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (uint32_t vertex = 0; vertex < level.vcount; ++vertex)
+        {
+            uint64_t degree = level.loops ? level.loops[vertex] : 0;
+            for (uint64_t i = level.offsets[vertex];
+                 i < level.offsets[vertex + 1]; ++i)
+            {
+                degree += edge_weight(&level, i);
+            }
+            degrees[vertex] = degree;
+        }
+
+        uint32_t* communities = move_vertices(&level, degrees, total, maps,
+            threads);
+        nb_communities = compact_communities(communities, level.vcount,
+            threads);
+        free(degrees);
+
+        // Follow the vertices of the graph into their new community
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+        {
+            vertex_communities[vertex] =
+                communities[vertex_communities[vertex]];
+        }
+
+        // Stop once no community was merged
+        bool merged = nb_communities < level.vcount;
+        louvain_graph_t next;
+        if (merged)
+        {
+            aggregate(&level, communities, nb_communities, maps, threads,
+                &next);
+        }
+
+        free(communities);
+        destroy_louvain_graph(&level);
+
+        if (!merged)
+        {
+            break;
+        }
+
+        level = next;
+    }
+
+    igraph_vector_init(membership, vcount);
+    for (uint32_t vertex = 0; vertex < vcount; ++vertex)
+    {
+        VECTOR(*membership)[vertex] = vertex_communities[vertex];
+    }
+
+    free(vertex_communities);
+    for (int thread = 0; thread < threads; ++thread)
+    {
+        destroy_community_map(&maps[thread]);
+    }
+    free(maps);
+
+    return nb_communities;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <igraph_datatype.h>
+
+#include "csr.h"
+
+/**
+ * @brief Compute the communities using a parallel Louvain (Lu et al.,
+ *        Grappolo): the vertices are colored so that no neighbors share a
+ *        color, the vertices of a color move at once to the neighboring
+ *        community of best modularity gain, then the communities are merged
+ *        into the vertices of the next level. The result does not depend on
+ *        the number of threads.
+ * @param graph The graph
+ * @param membership The membership of each vertex (out)
+ * @param threads The number of threads
+ * @return The number of clusters
+ */
+igraph_integer_t compute_communities_parallel_louvain(csr_t* graph,
+    igraph_vector_t* membership, int threads);
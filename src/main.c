@@ -4,25 +4,106 @@
 
 #include <igraph.h>
 
+#include "anytime.h"
+#include "bfs.h"
+#include "cache.h"
+#include "clusters.h"
+#include "csr.h"
+#include "diameter.h"
 #include "display.h"
+#include "loader.h"
+#include "louvain.h"
 #include "quotient.h"
 #include "sweep.h"
 #include "vector.h"
 #include "options.h"
+#include "pyramid.h"
 #include "communities.h"
+#include "stopwatch.h"
 
-static void normal_double_sweep(igraph_t* graph)
+static void normal_double_sweep(bfs_t* bfs, diameter_bound_t* bound)
 {
     fprintf(stderr, "\n--------------------------------------------------\n");
     fprintf(stderr, "DOUBLE SWEEP ALGORITHM: \n");
 
-    igraph_integer_t count;
-    igraph_integer_t diameter_sweep;
-    compute_statistics(graph, &count, &diameter_sweep);
+    igraph_integer_t diameter_sweep = double_sweep_ends(bfs, &bound->from,
+        &bound->to);
     fprintf(stderr, "Diameter (double sweep): %d\n", diameter_sweep);
+    bound->diameter = diameter_sweep;
 }
 
-static void quotient_starting_double_sweep(igraph_t* graph, options_t* options)
+static void normal_four_sweep(bfs_t* bfs, diameter_bound_t* bound)
+{
+    fprintf(stderr, "\n--------------------------------------------------\n");
+    fprintf(stderr, "4-SWEEP ALGORITHM: \n");
+
+    igraph_integer_t diameter = four_sweep_ends(bfs, &bound->from,
+        &bound->to, NULL);
+    fprintf(stderr, "Diameter (4-sweep): %d\n", diameter);
+    bound->diameter = diameter;
+}
+
+static void normal_sum_sweep(bfs_t* bfs, options_t* options,
+    diameter_bound_t* bound)
+{
+    fprintf(stderr, "\n--------------------------------------------------\n");
+    fprintf(stderr, "SUMSWEEP ALGORITHM: \n");
+
+    igraph_integer_t diameter = sum_sweep_ends(bfs, options->sweeps,
+        &bound->from, &bound->to);
+    fprintf(stderr, "Diameter (sumsweep, sweeps: %d): %d\n", options->sweeps,
+            diameter);
+    bound->diameter = diameter;
+}
+
+static void bounding_diameters_algorithm(bfs_t* bfs, options_t* options)
+{
+    fprintf(stderr, "\n--------------------------------------------------\n");
+    fprintf(stderr, "BOUNDING DIAMETERS ALGORITHM: \n");
+
+    bounds_t bounds;
+    bounding_diameters(bfs, options->max_bfs, &bounds);
+    fprintf(stderr, "Diameter (bounding diameters): [%d, %d] (bfs: %d)\n",
+            bounds.diameter_lower, bounds.diameter_upper, bounds.bfs_count);
+    fprintf(stderr, "Radius: [%d, %d] (center: %d)\n",
+            bounds.radius_lower, bounds.radius_upper, bounds.center);
+}
+
+static void membership_key(bfs_t* bfs, options_t* options,
+    membership_key_t* key)
+{
+    memset(key, 0, sizeof(membership_key_t));
+    key->graph_hash = csr_hash(bfs->graph);
+    key->vcount = bfs->graph->vcount;
+    key->algorithm = options->community_algorithm;
+
+    // The parameters changing the communities found
+    switch (options->community_algorithm)
+    {
+        case COMMUNITY_ALGORITHM_VORONOI:
+            key->parameters[0] = options->voronoi_seeds;
+            key->parameters[1] = options->voronoi_seeding;
+            break;
+        case COMMUNITY_ALGORITHM_PARALLEL_LOUVAIN:
+            // The threads share the vertices, which changes the moves made
+            key->parameters[0] = bfs->threads;
+            break;
+        case COMMUNITY_ALGORITHM_LABEL_PROPAGATION:
+            key->parameters[0] = options->label_propagation_cutoff;
+            key->parameters[1] = bfs->threads;
+            break;
+        case COMMUNITY_ALGORITHM_LEIDEN:
+            // The resolution 1 / (2 * ecount) and beta
+            key->parameters[0] = 1.0 / bfs->graph->offsets[bfs->graph->vcount];
+            key->parameters[1] = 0.01;
+            break;
+        default:
+            break;
+    }
+}
+
+static void quotient_starting_double_sweep(igraph_t* graph, bfs_t* bfs,
+    options_t* options, stopwatch_point_t* start, diameter_bound_t* bound)
 {
     fprintf(stderr, "\n--------------------------------------------------\n");
     fprintf(stderr, "QUOTIENT STARTING DOUBLE SWEEP ALGORITHM: \n");
@@ -30,36 +111,48 @@ static void quotient_starting_double_sweep(igraph_t* graph, options_t* options)
     igraph_vector_t membership;
     igraph_integer_t nb_clusters;
 
-    if (options->use_louvain)
+    if (options->membership_cache)
     {
-        // Compute the communities using louvain
-        fprintf(stderr, "Running Louvain\n");
-        nb_clusters = compute_communities_louvain(graph, &membership);
+        // Read the communities of a previous run on the same graph, or
+        // compute and save them
+        membership_key_t key;
+        membership_key(bfs, options, &key);
+        if (load_membership(options->membership_cache, &key, &membership,
+                &nb_clusters))
+        {
+            fprintf(stderr, "Loaded the communities from %s\n",
+                    options->membership_cache);
+        }
+        else
+        {
+            nb_clusters = compute_communities(graph, bfs, options,
+                &membership, true);
+            save_membership(options->membership_cache, &key, &membership,
+                nb_clusters);
+        }
     }
     else
     {
-        // Compute the communities using leiden
-        igraph_integer_t ecount = igraph_ecount(graph);
-        igraph_real_t resolution = 1.0 / (2.0 * ecount);
-        igraph_real_t beta = 0.01;
-
-        fprintf(stderr, "Running Leiden (resolution: %f, beta: %f)\n",
-                resolution, beta);
-
-        nb_clusters = compute_communities_leiden(
-                graph,
-                &membership,
-                resolution,
-                beta);
+        nb_clusters = compute_communities(graph, bfs, options, &membership,
+            true);
     }
 
     // Print the number of clusters
     fprintf(stderr, "Clusters: %d\n", nb_clusters);
 
-    // Print the modularity
-    igraph_real_t leiden_modularity;
-    igraph_modularity(graph, &membership, &leiden_modularity, NULL);
-    fprintf(stderr, "Modularity: %f\n", leiden_modularity);
+    if (budget_exhausted(start, options->time_budget, bound))
+    {
+        igraph_vector_destroy(&membership);
+        return;
+    }
+
+    if (options->stats & STATS_MODULARITY)
+    {
+        // Print the modularity
+        igraph_real_t leiden_modularity;
+        igraph_modularity(graph, &membership, &leiden_modularity, NULL);
+        fprintf(stderr, "Modularity: %f\n", leiden_modularity);
+    }
 
     if (options->print_membership)
     {
@@ -76,46 +169,115 @@ static void quotient_starting_double_sweep(igraph_t* graph, options_t* options)
         write_graph_dot_clustered(graph, stdout, nb_clusters, &membership);
     }
 
-    // Compute the quotient graph
+    // Compute the quotient graph, with the cut sizes when weighted
     igraph_t quotient;
-    quotient_graph(graph, nb_clusters, &membership, &quotient);
+    igraph_vector_t weights;
+    quotient_graph(graph, nb_clusters, &membership, &quotient,
+        options->weighted_quotient ? &weights : NULL, bfs->threads);
+
+    // Index the vertices of each cluster
+    clusters_t clusters;
+    init_clusters(&clusters, nb_clusters, &membership);
 
-    // Compute the cluster statistics
+    // Compute the cluster statistics, also needed to weight the quotient
+    bool statistics = (options->stats & STATS_CLUSTERS)
+        || options->weighted_quotient;
     igraph_vector_t counts;
     igraph_vector_t diameters;
-    compute_clusters_statistics(graph, nb_clusters, &membership, &counts,
-                                &diameters);
-
-    // Print the counts and diameters
-    fprintf(stderr, "Counts: ");
-    vector_int_fprint(stderr, &counts);
-    fprintf(stderr, "\nDiameters: ");
-    vector_int_fprint(stderr, &diameters);
-    fprintf(stderr, "\n");
+    if (statistics)
+    {
+        compute_clusters_statistics(bfs, &clusters, &counts, &diameters);
+    }
 
-    // Destroy the statistics
-    igraph_vector_destroy(&diameters);
-    igraph_vector_destroy(&counts);
+    if (options->stats & STATS_CLUSTERS)
+    {
+        // Print the counts and diameters
+        fprintf(stderr, "Counts: ");
+        vector_int_fprint(stderr, &counts);
+        fprintf(stderr, "\nDiameters: ");
+        vector_int_fprint(stderr, &diameters);
+        fprintf(stderr, "\n");
+    }
 
-    // Display basic graph information
-    graph_information("quotient", &quotient);
+    if (options->stats & STATS_PATH)
+    {
+        // Display basic graph information
+        graph_information("quotient", &quotient);
+    }
 
     if (options->dot_quotient)
     {
         // Write it as dot format on stdout
-        igraph_write_graph_dot(&quotient, stdout);
+        if (options->weighted_quotient)
+        {
+            write_graph_dot_weighted(&quotient, &counts, &diameters, &weights,
+                stdout);
+        }
+        else
+        {
+            igraph_write_graph_dot(&quotient, stdout);
+        }
+    }
+
+    if (options->weighted_quotient)
+    {
+        // Destroy the weights
+        igraph_vector_destroy(&weights);
     }
 
-    // Get the diameter
-    igraph_integer_t quotient_diameter;
     igraph_vector_t quotient_longest_path;
     igraph_vector_init(&quotient_longest_path, 0);
-    igraph_diameter(&quotient, &quotient_diameter, NULL, NULL,
-                    &quotient_longest_path, false, true);
-    fprintf(stderr, "Quotient diameter: %d\n", quotient_diameter);
-    fprintf(stderr, "Quotient longest path: ");
-    vector_int_fprint(stderr, &quotient_longest_path);
-    fprintf(stderr, "\n");
+    if (options->pyramid > 0)
+    {
+        // Go down the quotient graphs of the quotient graph
+        pyramid_t pyramid;
+        init_pyramid(&pyramid, &quotient, options->pyramid, options,
+            bfs->threads);
+        for (igraph_integer_t level = 1; level < pyramid.nb_levels; ++level)
+        {
+            fprintf(stderr, "Pyramid level %d: %d clusters\n", level,
+                    igraph_vcount(&pyramid.graphs[level]));
+        }
+        pyramid_longest_path(&pyramid, &quotient_longest_path);
+        destroy_pyramid(&pyramid);
+
+        fprintf(stderr, "Quotient longest path length (pyramid): %d\n",
+                (igraph_integer_t) igraph_vector_size(&quotient_longest_path)
+                - 1);
+    }
+    else if (options->weighted_quotient)
+    {
+        // Get the longest path, counting the cluster diameters
+        igraph_real_t length = quotient_weighted_longest_path(&quotient,
+            &counts, &diameters, &quotient_longest_path);
+        fprintf(stderr, "Quotient weighted longest path length: %f\n",
+                length);
+    }
+    else
+    {
+        // Get the diameter, a lower bound above the threshold or when the
+        // quotient graph is disconnected
+        bool exact;
+        igraph_integer_t diameter = quotient_diameter(&quotient,
+            options->quotient_threshold, &quotient_longest_path, &exact);
+        fprintf(stderr, "Quotient diameter%s: %d\n",
+                exact ? "" : " (lower bound)", diameter);
+    }
+
+    if (options->stats & STATS_PATH)
+    {
+        // Print the communities along the path
+        fprintf(stderr, "Quotient longest path: ");
+        vector_int_fprint(stderr, &quotient_longest_path);
+        fprintf(stderr, "\n");
+    }
+
+    if (statistics)
+    {
+        // Destroy the statistics
+        igraph_vector_destroy(&diameters);
+        igraph_vector_destroy(&counts);
+    }
 
     // Destroy the quotient graph
     igraph_destroy(&quotient);
@@ -123,45 +285,112 @@ static void quotient_starting_double_sweep(igraph_t* graph, options_t* options)
     // Take a starting community for double-sweep
     igraph_integer_t starting_community = VECTOR(quotient_longest_path)[0];
 
+    // Past the budget, the anytime sweeps below only print the bound
+    bool exhausted = budget_exhausted(start, options->time_budget, bound);
+
+    if (options->exact && !exhausted)
+    {
+        // Take the center of the community in the middle of the longest path
+        igraph_integer_t central_community = VECTOR(quotient_longest_path)[
+            igraph_vector_size(&quotient_longest_path) / 2];
+        igraph_integer_t root = community_center(bfs, &clusters,
+            central_community);
+
+        // Compute the exact diameter, pruned by the bound of the first sweeps
+        igraph_integer_t bfs_count;
+        igraph_integer_t from = bound->from;
+        igraph_integer_t to = bound->to;
+        igraph_integer_t diameter = ifub_diameter(bfs, root, bound->diameter,
+            &from, &to, &bfs_count);
+        fprintf(stderr, "Diameter (exact, iFUB from community %d): %d "
+                        "(bfs: %d)\n", central_community, diameter, bfs_count);
+
+        if (diameter > bound->diameter)
+        {
+            bound->diameter = diameter;
+            bound->from = from;
+            bound->to = to;
+        }
+    }
+
     // Destroy the longest path vector
     igraph_vector_destroy(&quotient_longest_path);
 
-    if (options->quotient_try_all)
+    if (options->time_budget > 0)
+    {
+        // Keep sweeping from promising starts until the budget runs out
+        igraph_integer_t bfs_count;
+        igraph_integer_t diameter = anytime_double_sweep(bfs, &clusters,
+            starting_community, bound, start, options->time_budget,
+            &bfs_count);
+        fprintf(stderr, "Diameter (anytime from starting community, "
+                        "budget: %fs, bfs: %d): %d\n",
+                options->time_budget, bfs_count, diameter);
+    }
+    else if (options->quotient_try_all)
     {
         // Compute the double sweep starting from the vertices in a community
-        igraph_integer_t diameter = double_sweep_from_community(graph,
-            &membership, starting_community);
+        igraph_integer_t diameter = double_sweep_from_community(bfs,
+            &clusters, starting_community);
         fprintf(stderr, "Diameter (double sweep from starting community, "
                         "n: all): %d\n", diameter);
     }
     else
     {
-        // Try the double sweep with different number of tries
-        for (igraph_integer_t n = 1; n < 10; ++n)
+        // Compute the double sweep starting from the vertices in a community,
+        // reporting the diameter after each try
+        community_sweep_t sweep;
+        init_community_sweep(&sweep, bfs, &clusters, starting_community,
+            options->quotient_stable > 0 ? -1 : 9);
+
+        if (options->quotient_stable > 0)
         {
-            // Compute the double sweep starting from the vertices in a community
-            igraph_integer_t diameter = double_sweep_from_community_tries(graph,
-                &membership, starting_community, n, false);
+            // Stop once the diameter did not change for some tries
+            while (sweep.stable < options->quotient_stable
+                   && community_sweep_next(&sweep))
+            {
+            }
             fprintf(stderr, "Diameter (double sweep from starting community, "
-                            "n: %d): %d\n", n, diameter);
+                            "stable: %d, n: %d): %d\n",
+                    options->quotient_stable, sweep.tries, sweep.diameter);
+        }
+        else
+        {
+            for (igraph_integer_t n = 1; n < 10; ++n)
+            {
+                community_sweep_next(&sweep);
+                fprintf(stderr, "Diameter (double sweep from starting community, "
+                                "n: %d): %d\n", n, sweep.diameter);
+            }
         }
-
     }
 
     // Destroy the communities
+    destroy_clusters(&clusters);
     igraph_vector_destroy(&membership);
 }
 
 int main(int argc, char** argv)
 {
+    // The time budget is counted from the start
+    stopwatch_point_t start;
+    create_stopwatch_point(&start);
+
     options_t options;
     if (!parse_options(argc, argv, &options))
         return 1;
 
+    // Create a new graph, with the representation used by the sweeps
     igraph_t graph;
-    // Create a new graph
-    igraph_read_graph_edgelist(&graph, options.input, 0, false);
+    csr_t csr;
+    if (!load_graph(options.input, &graph, &csr, options.threads))
+        return 1;
 
+    bfs_t bfs;
+    init_bfs(&bfs, &csr);
+    bfs.engine = options.bfs_engine;
+    bfs.batched = options.batched_sweeps;
+    bfs.threads = options.threads;
 
     // Useful Print
     // ------------------------------
@@ -182,13 +411,46 @@ int main(int argc, char** argv)
 
     // Double Sweep Algorithm
     // ------------------------------
-    normal_double_sweep(&graph);
+    diameter_bound_t bound;
+    switch (options.sweep_strategy)
+    {
+        case SWEEP_STRATEGY_FOUR:
+            normal_four_sweep(&bfs, &bound);
+            break;
+        case SWEEP_STRATEGY_SUM:
+            normal_sum_sweep(&bfs, &options, &bound);
+            break;
+        case SWEEP_STRATEGY_DOUBLE:
+        default:
+            normal_double_sweep(&bfs, &bound);
+            break;
+    }
+
+    // The phases stop once the time budget runs out, with the bound so far
+    bool exhausted = budget_exhausted(&start, options.time_budget, &bound);
+
+
+    // Bounding Diameters Algorithm
+    // ------------------------------
+    if (options.bounding_diameters && !exhausted)
+    {
+        bounding_diameters_algorithm(&bfs, &options);
+        exhausted = budget_exhausted(&start, options.time_budget, &bound);
+    }
 
 
     // Quotient Starting Double Sweep Algorithm
     // ------------------------------
-    quotient_starting_double_sweep(&graph, &options);
+    if (!exhausted)
+    {
+        quotient_starting_double_sweep(&graph, &bfs, &options, &start,
+            &bound);
+    }
+
 
+    // Destroy the sweep representation
+    destroy_bfs(&bfs);
+    destroy_csr(&csr);
 
     // Destroy the graph
     igraph_destroy(&graph);
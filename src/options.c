@@ -1,5 +1,6 @@
 #include "options.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 
@@ -54,10 +55,96 @@ static int handle_use_louvain(int argc, char** argv, options_t* options)
 {
     (void) argc;
     (void) argv;
-    options->use_louvain = true;
+    options->community_algorithm = COMMUNITY_ALGORITHM_LOUVAIN;
     return 1;
 }
 
+static int handle_use_parallel_louvain(int argc, char** argv,
+    options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->community_algorithm = COMMUNITY_ALGORITHM_PARALLEL_LOUVAIN;
+    return 1;
+}
+
+static int handle_use_voronoi(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->community_algorithm = COMMUNITY_ALGORITHM_VORONOI;
+    return 1;
+}
+
+static int handle_use_label_propagation(int argc, char** argv,
+    options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->community_algorithm = COMMUNITY_ALGORITHM_LABEL_PROPAGATION;
+    return 1;
+}
+
+static int handle_label_propagation_cutoff(int argc, char** argv,
+    options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    double cutoff = strtod(argv[1], &end);
+    if (*end != '\0' || cutoff < 0 || cutoff > 1)
+    {
+        return -1;
+    }
+
+    options->label_propagation_cutoff = cutoff;
+    return 2;
+}
+
+static int handle_voronoi_seeds(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long seeds = strtol(argv[1], &end, 10);
+    if (*end != '\0' || seeds < 1)
+    {
+        return -1;
+    }
+
+    options->voronoi_seeds = seeds;
+    return 2;
+}
+
+static int handle_voronoi_seeding(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    if (strcmp(argv[1], "degree") == 0)
+    {
+        options->voronoi_seeding = VORONOI_SEEDING_DEGREE;
+    }
+    else if (strcmp(argv[1], "farthest") == 0)
+    {
+        options->voronoi_seeding = VORONOI_SEEDING_FARTHEST;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return 2;
+}
+
 static int handle_print_membership(int argc, char** argv, options_t* options)
 {
     (void) argc;
@@ -66,6 +153,104 @@ static int handle_print_membership(int argc, char** argv, options_t* options)
     return 1;
 }
 
+static int handle_estimate_only(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->estimate_only = true;
+    return 1;
+}
+
+static int handle_stats(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->stats |= STATS_ALL;
+    return 1;
+}
+
+static int handle_stats_modularity(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->stats |= STATS_MODULARITY;
+    return 1;
+}
+
+static int handle_stats_clusters(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->stats |= STATS_CLUSTERS;
+    return 1;
+}
+
+static int handle_stats_path(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->stats |= STATS_PATH;
+    return 1;
+}
+
+static int handle_membership_cache(int argc, char** argv,
+    options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    options->membership_cache = argv[1];
+    return 2;
+}
+
+static int handle_weighted_quotient(int argc, char** argv,
+    options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->weighted_quotient = true;
+    return 1;
+}
+
+static int handle_quotient_threshold(int argc, char** argv,
+    options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long threshold = strtol(argv[1], &end, 10);
+    if (*end != '\0' || threshold < 0)
+    {
+        return -1;
+    }
+
+    options->quotient_threshold = threshold;
+    return 2;
+}
+
+static int handle_pyramid(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long pyramid = strtol(argv[1], &end, 10);
+    if (*end != '\0' || pyramid < 1)
+    {
+        return -1;
+    }
+
+    options->pyramid = pyramid;
+    return 2;
+}
+
 static int handle_quotient_try_all(int argc, char** argv, options_t* options)
 {
     (void) argc;
@@ -74,6 +259,171 @@ static int handle_quotient_try_all(int argc, char** argv, options_t* options)
     return 1;
 }
 
+static int handle_quotient_stable(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long stable = strtol(argv[1], &end, 10);
+    if (*end != '\0' || stable < 1)
+    {
+        return -1;
+    }
+
+    options->quotient_stable = stable;
+    return 2;
+}
+
+static int handle_time_budget(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    double budget = strtod(argv[1], &end);
+    if (*end != '\0' || budget <= 0)
+    {
+        return -1;
+    }
+
+    options->time_budget = budget;
+    return 2;
+}
+
+static int handle_exact(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->exact = true;
+    return 1;
+}
+
+static int handle_bounding_diameters(int argc, char** argv,
+    options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->bounding_diameters = true;
+    return 1;
+}
+
+static int handle_max_bfs(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long max_bfs = strtol(argv[1], &end, 10);
+    if (*end != '\0' || max_bfs < 0)
+    {
+        return -1;
+    }
+
+    options->max_bfs = max_bfs;
+    return 2;
+}
+
+static int handle_sweep_strategy(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    if (strcmp(argv[1], "double") == 0)
+    {
+        options->sweep_strategy = SWEEP_STRATEGY_DOUBLE;
+    }
+    else if (strcmp(argv[1], "4-sweep") == 0)
+    {
+        options->sweep_strategy = SWEEP_STRATEGY_FOUR;
+    }
+    else if (strcmp(argv[1], "sumsweep") == 0)
+    {
+        options->sweep_strategy = SWEEP_STRATEGY_SUM;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return 2;
+}
+
+static int handle_sweeps(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long sweeps = strtol(argv[1], &end, 10);
+    if (*end != '\0' || sweeps < 1)
+    {
+        return -1;
+    }
+
+    options->sweeps = sweeps;
+    return 2;
+}
+
+static int handle_bfs_engine(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    if (strcmp(argv[1], "top-down") == 0)
+    {
+        options->bfs_engine = BFS_ENGINE_TOP_DOWN;
+    }
+    else if (strcmp(argv[1], "direction-optimizing") == 0)
+    {
+        options->bfs_engine = BFS_ENGINE_DIRECTION_OPTIMIZING;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return 2;
+}
+
+static int handle_batched_sweeps(int argc, char** argv, options_t* options)
+{
+    (void) argc;
+    (void) argv;
+    options->batched_sweeps = true;
+    return 1;
+}
+
+static int handle_threads(int argc, char** argv, options_t* options)
+{
+    if (argc < 2)
+    {
+        return -1;
+    }
+
+    char* end;
+    long threads = strtol(argv[1], &end, 10);
+    if (*end != '\0' || threads < 1)
+    {
+        return -1;
+    }
+
+    options->threads = threads;
+    return 2;
+}
+
 static option_t all_options[] = {
     {
         .option = "--help",
@@ -100,16 +450,141 @@ static option_t all_options[] = {
         .help = "use louvain for communities computation",
         .callback = handle_use_louvain,
     },
+    {
+        .option = "--use-parallel-louvain",
+        .help = "use the built-in parallel louvain for communities computation, with the threads of --threads",
+        .callback = handle_use_parallel_louvain,
+    },
+    {
+        .option = "--use-voronoi",
+        .help = "use the cells of the closest seeds (one multi-source breadth first search) as communities",
+        .callback = handle_use_voronoi,
+    },
+    {
+        .option = "--use-label-propagation",
+        .help = "use label propagation for communities computation, with the threads of --threads",
+        .callback = handle_use_label_propagation,
+    },
+    {
+        .option = "--label-propagation-cutoff",
+        .help = "[F] stop the label propagation once less than the fraction F of the labels change in a round (default: 0.001)",
+        .callback = handle_label_propagation_cutoff,
+    },
+    {
+        .option = "--voronoi-seeds",
+        .help = "[K] the number of seeds of --use-voronoi (default: the square root of the number of vertices)",
+        .callback = handle_voronoi_seeds,
+    },
+    {
+        .option = "--voronoi-seeding",
+        .help = "[degree|farthest] the seeds of --use-voronoi: the highest degree vertices, or the farthest from the previous seeds (default: degree)",
+        .callback = handle_voronoi_seeding,
+    },
+    {
+        .option = "--membership-cache",
+        .help = "[FILE] read the communities from FILE when it was written for the same graph and community detection, else compute and write them to FILE",
+        .callback = handle_membership_cache,
+    },
     {
         .option = "--print-membership",
         .help = "print the membership of each vertex from the original graph",
         .callback = handle_print_membership,
     },
+    {
+        .option = "--estimate-only",
+        .help = "only print the diameter estimates, without the statistics below unless some are asked for",
+        .callback = handle_estimate_only,
+    },
+    {
+        .option = "--stats",
+        .help = "print all the statistics (default, unless --estimate-only or the options below are given, in any order: then only the statistics asked for are printed)",
+        .callback = handle_stats,
+    },
+    {
+        .option = "--stats-modularity",
+        .help = "print the modularity of the communities",
+        .callback = handle_stats_modularity,
+    },
+    {
+        .option = "--stats-clusters",
+        .help = "print the size and the diameter of each cluster",
+        .callback = handle_stats_clusters,
+    },
+    {
+        .option = "--stats-path",
+        .help = "print the quotient graph information and its longest path",
+        .callback = handle_stats_path,
+    },
+    {
+        .option = "--weighted-quotient",
+        .help = "weight the quotient graph with the cut sizes and the cluster sizes and diameters, and start from the end of its longest path, counting the cluster diameters",
+        .callback = handle_weighted_quotient,
+    },
+    {
+        .option = "--quotient-threshold",
+        .help = "[K] only estimate the quotient diameter (4-sweep) above K clusters, instead of computing it with iFUB (default: 0, no limit)",
+        .callback = handle_quotient_threshold,
+    },
+    {
+        .option = "--pyramid",
+        .help = "[K] build quotient graphs of the quotient graph until at most K clusters, and find the starting community from the top one down",
+        .callback = handle_pyramid,
+    },
     {
         .option = "--quotient-try-all",
         .help = "try all the start vertices in the selected community",
         .callback = handle_quotient_try_all,
     },
+    {
+        .option = "--quotient-stable",
+        .help = "[K] try the start vertices in the selected community until the diameter did not change for K tries",
+        .callback = handle_quotient_stable,
+    },
+    {
+        .option = "--time-budget",
+        .help = "[SECONDS] sweep from the selected community, then from the peripheral vertices found, until SECONDS after the start, printing each improvement",
+        .callback = handle_time_budget,
+    },
+    {
+        .option = "--exact",
+        .help = "compute the exact diameter with iFUB, from the center of the community in the middle of the quotient longest path",
+        .callback = handle_exact,
+    },
+    {
+        .option = "--bounding-diameters",
+        .help = "bound the diameter and the radius with BoundingDiameters",
+        .callback = handle_bounding_diameters,
+    },
+    {
+        .option = "--max-bfs",
+        .help = "[N] stop BoundingDiameters after N bfs, with the current bounds (default: 0, no limit)",
+        .callback = handle_max_bfs,
+    },
+    {
+        .option = "--sweep-strategy",
+        .help = "[double|4-sweep|sumsweep] the estimation done on the whole graph (default: double)",
+        .callback = handle_sweep_strategy,
+    },
+    {
+        .option = "--sweeps",
+        .help = "[N] the number of breadth first searches of sumsweep (default: 4)",
+        .callback = handle_sweeps,
+    },
+    {
+        .option = "--bfs-engine",
+        .help = "[top-down|direction-optimizing] the breadth first search used by the sweeps (default: top-down)",
+        .callback = handle_bfs_engine,
+    },
+    {
+        .option = "--batched-sweeps",
+        .help = "run the sweeps from the starting community 64 sources at a time (multi-source bfs)",
+        .callback = handle_batched_sweeps,
+    },
+    {
+        .option = "--threads",
+        .help = "[N] the number of threads of the file loading, the top-down sweeps, the cluster statistics, the quotient graph construction, parallel Louvain and label propagation (default: 1)",
+        .callback = handle_threads,
+    },
 };
 
 bool parse_options(int argc, char** argv, options_t* options)
@@ -120,9 +595,28 @@ bool parse_options(int argc, char** argv, options_t* options)
     options->dot_original = false;
     options->dot_quotient = false;
     options->dot_colored = false;
-    options->use_louvain = false;
+    options->community_algorithm = COMMUNITY_ALGORITHM_LEIDEN;
+    options->label_propagation_cutoff = LABEL_PROPAGATION_DEFAULT_CUTOFF;
+    options->voronoi_seeds = 0;
+    options->voronoi_seeding = VORONOI_SEEDING_DEGREE;
+    options->membership_cache = NULL;
     options->print_membership = false;
+    options->estimate_only = false;
+    options->stats = 0;
+    options->weighted_quotient = false;
+    options->quotient_threshold = 0;
+    options->pyramid = 0;
     options->quotient_try_all = false;
+    options->quotient_stable = 0;
+    options->time_budget = 0;
+    options->exact = false;
+    options->bounding_diameters = false;
+    options->max_bfs = 0;
+    options->sweep_strategy = SWEEP_STRATEGY_DOUBLE;
+    options->sweeps = SUM_SWEEP_DEFAULT_SWEEPS;
+    options->bfs_engine = BFS_ENGINE_TOP_DOWN;
+    options->batched_sweeps = false;
+    options->threads = 1;
 
     int options_count = sizeof(all_options) / sizeof(option_t);
     int current_arg = 1;
@@ -145,6 +639,12 @@ bool parse_options(int argc, char** argv, options_t* options)
         current_arg += found;
     }
 
+    // Without any statistic asked for, all of them unless estimating only
+    if (options->stats == 0 && !options->estimate_only)
+    {
+        options->stats = STATS_ALL;
+    }
+
     if (!options->help)
     {
         // If we don't have the filename at the end
@@ -3,6 +3,24 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#include "bfs.h"
+#include "communities.h"
+#include "sweep.h"
+
+typedef enum stats
+{
+    // The modularity of the communities
+    STATS_MODULARITY = 1,
+
+    // The size and the diameter of each cluster (two bfs per cluster)
+    STATS_CLUSTERS = 2,
+
+    // The quotient graph information and its longest path
+    STATS_PATH = 4,
+
+    STATS_ALL = STATS_MODULARITY | STATS_CLUSTERS | STATS_PATH,
+} stats_t;
+
 typedef struct options
 {
     FILE* input;
@@ -14,11 +32,36 @@ typedef struct options
     bool dot_colored;
     bool dot_quotient;
 
-    bool use_louvain;
+    community_algorithm_t community_algorithm;
+    double label_propagation_cutoff;
+    int voronoi_seeds;
+    voronoi_seeding_t voronoi_seeding;
+    char* membership_cache;
+
+    bool weighted_quotient;
+    int quotient_threshold;
+    int pyramid;
 
     bool quotient_try_all;
+    int quotient_stable;
+    double time_budget;
+
+    bool exact;
+
+    bool bounding_diameters;
+    int max_bfs;
 
     bool print_membership;
+    bool estimate_only;
+    int stats;
+
+    sweep_strategy_t sweep_strategy;
+    int sweeps;
+
+    bfs_engine_t bfs_engine;
+    bool batched_sweeps;
+
+    int threads;
 } options_t;
 
 /**
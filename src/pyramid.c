@@ -0,0 +1,143 @@
+#include "pyramid.h"
+
+#include <stdlib.h>
+
+#include <igraph.h>
+
+#include "bfs.h"
+#include "communities.h"
+#include "csr.h"
+#include "diameter.h"
+#include "quotient.h"
+
+void init_pyramid(pyramid_t* pyramid, igraph_t* quotient,
+    igraph_integer_t max_top, options_t* options, int threads)
+{
+    igraph_integer_t capacity = 1;
+    pyramid->nb_levels = 1;
+    pyramid->graphs = malloc(capacity * sizeof(igraph_t));
+    pyramid->clusters = malloc(capacity * sizeof(clusters_t));
+    igraph_copy(&pyramid->graphs[0], quotient);
+
+    while (true)
+    {
+        igraph_t* graph = &pyramid->graphs[pyramid->nb_levels - 1];
+        igraph_integer_t vcount = igraph_vcount(graph);
+        if (vcount <= max_top)
+        {
+            break;
+        }
+
+        // Compute the communities of the current top, with the algorithm and
+        // the parameters of the options
+        csr_t csr;
+        init_csr(&csr, graph);
+        bfs_t bfs;
+        init_bfs(&bfs, &csr);
+        bfs.threads = threads;
+        igraph_vector_t membership;
+        igraph_integer_t nb_clusters = compute_communities(graph, &bfs,
+            options, &membership, false);
+        destroy_bfs(&bfs);
+        destroy_csr(&csr);
+
+        // Stop when the communities do not shrink the graph, or would leave
+        // no path at the top
+        if (nb_clusters == vcount || nb_clusters < 2)
+        {
+            igraph_vector_destroy(&membership);
+            break;
+        }
+
+        if (pyramid->nb_levels == capacity)
+        {
+            capacity *= 2;
+            pyramid->graphs = realloc(pyramid->graphs,
+                capacity * sizeof(igraph_t));
+            pyramid->clusters = realloc(pyramid->clusters,
+                capacity * sizeof(clusters_t));
+            graph = &pyramid->graphs[pyramid->nb_levels - 1];
+        }
+
+        // Add the quotient graph of the current top as the new top
+        init_clusters(&pyramid->clusters[pyramid->nb_levels - 1], nb_clusters,
+            &membership);
+        quotient_graph(graph, nb_clusters, &membership,
+            &pyramid->graphs[pyramid->nb_levels], NULL, threads);
+        pyramid->nb_levels += 1;
+
+        igraph_vector_destroy(&membership);
+    }
+}
+
+void destroy_pyramid(pyramid_t* pyramid)
+{
+    for (igraph_integer_t level = 0; level < pyramid->nb_levels; ++level)
+    {
+        igraph_destroy(&pyramid->graphs[level]);
+        if (level + 1 < pyramid->nb_levels)
+        {
+            destroy_clusters(&pyramid->clusters[level]);
+        }
+    }
+    free(pyramid->clusters);
+    free(pyramid->graphs);
+}
+
+// Get the vertex of a cluster visited last by a bfs from the source, or the
+// last vertex visited if the cluster is not reachable (only reached vertices
+// can end a path from the source)
+static igraph_integer_t farthest_in_cluster(bfs_t* bfs, clusters_t* clusters,
+    igraph_integer_t source, igraph_integer_t cluster, size_t* levels)
+{
+    sweep_result_t stats = bfs_levels(bfs, source, levels);
+
+    for (size_t i = levels[stats.max_distance + 1]; i > 0; --i)
+    {
+        uint32_t vertex = bfs->queue[i - 1];
+        if (clusters->membership[vertex] == (uint32_t) cluster)
+        {
+            return vertex;
+        }
+    }
+
+    return stats.last_vertex;
+}
+
+void pyramid_longest_path(pyramid_t* pyramid, igraph_vector_t* path)
+{
+    // Start from the longest path of the top
+    bool exact;
+    quotient_diameter(&pyramid->graphs[pyramid->nb_levels - 1], 0, path,
+        &exact);
+    igraph_integer_t from = VECTOR(*path)[0];
+    igraph_integer_t to = VECTOR(*path)[igraph_vector_size(path) - 1];
+
+    for (igraph_integer_t level = pyramid->nb_levels - 2; level >= 0; --level)
+    {
+        csr_t csr;
+        init_csr(&csr, &pyramid->graphs[level]);
+        bfs_t bfs;
+        init_bfs(&bfs, &csr);
+
+        // Refine the ends into their clusters: the start as far as possible
+        // from the center of the end, then the end as far as possible from
+        // the start
+        clusters_t* clusters = &pyramid->clusters[level];
+        size_t* levels = malloc((csr.vcount + 1) * sizeof(size_t));
+
+        igraph_integer_t center = community_center(&bfs, clusters, to);
+        from = farthest_in_cluster(&bfs, clusters, center, from, levels);
+        to = farthest_in_cluster(&bfs, clusters, from, to, levels);
+
+        if (level == 0)
+        {
+            // Write the path between the ends at the bottom
+            shortest_path(&bfs, from, to, path);
+        }
+
+        free(levels);
+        destroy_bfs(&bfs);
+        destroy_csr(&csr);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include <igraph_datatype.h>
+
+#include "clusters.h"
+#include "communities.h"
+
+typedef struct pyramid
+{
+    igraph_integer_t nb_levels;
+    // The quotient graph of each level, graphs[0] is the one of the input
+    // graph and graphs[nb_levels - 1] the top
+    igraph_t* graphs;
+    // The clusters of the vertices of graphs[l] in graphs[l + 1]
+    clusters_t* clusters;
+} pyramid_t;
+
+/**
+ * @brief Build quotient graphs of the quotient graph, until the top one is
+ *        small enough or the communities do not shrink it anymore
+ * @param pyramid The pyramid to initialize
+ * @param quotient The quotient graph of the input graph (copied)
+ * @param max_top The number of vertices under which a quotient graph is the top
+ * @param options The community detection applied to each level, and its
+ *                parameters
+ * @param threads The number of threads building the quotient graphs and
+ *                detecting the communities
+ */
+void init_pyramid(pyramid_t* pyramid, igraph_t* quotient,
+    igraph_integer_t max_top, options_t* options, int threads);
+
+/**
+ * @brief Destroy the pyramid
+ * @param pyramid The pyramid to destroy
+ */
+void destroy_pyramid(pyramid_t* pyramid);
+
+/**
+ * @brief Find a long path of the bottom quotient graph top-down: the ends of
+ *        the longest path of the top graph are refined at each level to the
+ *        farthest apart vertices of their clusters
+ * @param pyramid The pyramid
+ * @param path The vertices of the bottom quotient graph along the path, from
+ *             the starting one (out, initialized)
+ */
+void pyramid_longest_path(pyramid_t* pyramid, igraph_vector_t* path);
@@ -1,45 +1,272 @@
 #include "quotient.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <igraph.h>
 
+#include "bfs.h"
+#include "csr.h"
+#include "diameter.h"
+#include "sweep.h"
+
+// Sort the keys (lower than 2^bits) and their counts with an LSD radix sort
+// on bytes, using the buffers of the same size
+static void radix_sort(uint64_t* keys, uint64_t* counts, uint64_t* key_buffer,
+    uint64_t* count_buffer, size_t size, int bits)
+{
+    uint64_t* source_keys = keys;
+    uint64_t* source_counts = counts;
+
+    for (int shift = 0; shift < bits; shift += 8)
+    {
+        size_t offsets[257] = { 0 };
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            offsets[((source_keys[i] >> shift) & 0xFF) + 1] += 1;
+        }
+
+        for (int digit = 0; digit < 256; ++digit)
+        {
+            offsets[digit + 1] += offsets[digit];
+        }
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            size_t position = offsets[(source_keys[i] >> shift) & 0xFF]++;
+            key_buffer[position] = source_keys[i];
+            count_buffer[position] = source_counts[i];
+        }
+
+        // The buffers become the source of the next pass
+        uint64_t* swap = source_keys;
+        source_keys = key_buffer;
+        key_buffer = swap;
+        swap = source_counts;
+        source_counts = count_buffer;
+        count_buffer = swap;
+    }
+
+    if (source_keys != keys)
+    {
+        memcpy(keys, source_keys, size * sizeof(uint64_t));
+        memcpy(counts, source_counts, size * sizeof(uint64_t));
+    }
+}
+
+// Merge the equal sorted keys, adding their counts, return the new size
+static size_t merge_duplicates(uint64_t* keys, uint64_t* counts, size_t size)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (kept > 0 && keys[i] == keys[kept - 1])
+        {
+            counts[kept - 1] += counts[i];
+        }
+        else
+        {
+            keys[kept] = keys[i];
+            counts[kept] = counts[i];
+            kept += 1;
+        }
+    }
+    return kept;
+}
+
 void quotient_graph(igraph_t* graph, igraph_integer_t nb_clusters,
-    igraph_vector_t* membership, igraph_t* result)
+    igraph_vector_t* membership, igraph_t* result, igraph_vector_t* weights,
+    int threads)
 {
-    // Initialize the graph
-    igraph_small(result, nb_clusters, IGRAPH_UNDIRECTED, -1);
+    igraph_integer_t ecount = igraph_ecount(graph);
+    size_t capacity = ecount ? ecount : 1;
 
-    // Initialize the selector
-    igraph_es_t selector;
-    igraph_es_all(&selector, IGRAPH_EDGEORDER_ID);
+    // An edge between the clusters a < b is the key a * nb_clusters + b
+    int bits = 0;
+    while (bits < 64 && ((uint64_t) nb_clusters * nb_clusters) >> bits)
+    {
+        bits += 8;
+    }
 
-    // Initialize the iterator
-    igraph_eit_t iterator;
-    igraph_eit_create(graph, selector, &iterator);
+    uint64_t* keys = malloc(capacity * sizeof(uint64_t));
+    uint64_t* counts = malloc(capacity * sizeof(uint64_t));
+    uint64_t* key_buffer = malloc(capacity * sizeof(uint64_t));
+    uint64_t* count_buffer = malloc(capacity * sizeof(uint64_t));
+    size_t* sizes = calloc(threads + 1, sizeof(size_t));
 
-    while (!IGRAPH_EIT_END(iterator))
+    // Collect and merge the edges of each range, in place
+    #pragma omp parallel for num_threads(threads) schedule(static)
+    for (int t = 0; t < threads; ++t)
     {
-        igraph_integer_t from, to;
-        igraph_edge(graph, IGRAPH_EIT_GET(iterator), &from, &to);
+        size_t begin = (size_t) ecount * t / threads;
+        size_t end = (size_t) ecount * (t + 1) / threads;
+        size_t size = 0;
+
+        for (size_t e = begin; e < end; ++e)
+        {
+            uint64_t from = VECTOR(*membership)[IGRAPH_FROM(graph, e)];
+            uint64_t to = VECTOR(*membership)[IGRAPH_TO(graph, e)];
+
+            if (from != to)
+            {
+                keys[begin + size] = from < to
+                    ? from * nb_clusters + to : to * nb_clusters + from;
+                counts[begin + size] = 1;
+                size += 1;
+            }
+        }
 
-        igraph_integer_t quotient_from = VECTOR(*membership)[from];
-        igraph_integer_t quotient_to = VECTOR(*membership)[to];
+        radix_sort(keys + begin, counts + begin, key_buffer + begin,
+            count_buffer + begin, size, bits);
+        sizes[t + 1] = merge_duplicates(keys + begin, counts + begin, size);
+    }
 
-        if (quotient_from != quotient_to)
+    // Gather the ranges
+    for (int t = 0; t < threads; ++t)
+    {
+        size_t begin = (size_t) ecount * t / threads;
+        memmove(keys + sizes[t], keys + begin,
+            sizes[t + 1] * sizeof(uint64_t));
+        memmove(counts + sizes[t], counts + begin,
+            sizes[t + 1] * sizeof(uint64_t));
+        sizes[t + 1] += sizes[t];
+    }
+
+    // Merge the edges found in many ranges
+    size_t size = sizes[threads];
+    radix_sort(keys, counts, key_buffer, count_buffer, size, bits);
+    size = merge_duplicates(keys, counts, size);
+
+    // Create the graph at once
+    igraph_vector_t edges;
+    igraph_vector_init(&edges, 2 * size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        VECTOR(edges)[2 * i] = keys[i] / nb_clusters;
+        VECTOR(edges)[2 * i + 1] = keys[i] % nb_clusters;
+    }
+
+    igraph_create(result, &edges, nb_clusters, IGRAPH_UNDIRECTED);
+
+    if (weights != NULL)
+    {
+        // The edges keep their order, weight them by their multiplicity
+        igraph_vector_init(weights, size);
+        for (size_t i = 0; i < size; ++i)
         {
-            igraph_bool_t connected;
-            igraph_are_connected(result, quotient_from, quotient_to, &connected);
-            if (!connected)
+            VECTOR(*weights)[i] = counts[i];
+        }
+    }
+
+    igraph_vector_destroy(&edges);
+    free(sizes);
+    free(count_buffer);
+    free(key_buffer);
+    free(counts);
+    free(keys);
+}
+
+igraph_real_t quotient_weighted_longest_path(igraph_t* quotient,
+    igraph_vector_t* counts, igraph_vector_t* diameters, igraph_vector_t* path)
+{
+    igraph_integer_t vcount = igraph_vcount(quotient);
+    igraph_integer_t ecount = igraph_ecount(quotient);
+
+    // Crossing a cluster costs half its diameter on the way in and on the
+    // way out, and each hop one edge
+    igraph_vector_t lengths;
+    igraph_vector_init(&lengths, ecount);
+    for (igraph_integer_t edge = 0; edge < ecount; ++edge)
+    {
+        igraph_integer_t from = IGRAPH_FROM(quotient, edge);
+        igraph_integer_t to = IGRAPH_TO(quotient, edge);
+        VECTOR(lengths)[edge] = 1.0
+            + (VECTOR(*diameters)[from] + VECTOR(*diameters)[to]) / 2.0;
+    }
+
+    // The ends are chosen with their whole diameters counted, and on ties
+    // with the most vertices to start from
+    igraph_real_t best_length = 0;
+    igraph_real_t best_count = -1;
+    igraph_integer_t best_from = 0;
+    igraph_integer_t best_to = 0;
+    igraph_matrix_t distances;
+    igraph_matrix_init(&distances, 0, 0);
+    for (igraph_integer_t from = 0; from < vcount; ++from)
+    {
+        igraph_shortest_paths_dijkstra(quotient, &distances,
+            igraph_vss_1(from), igraph_vss_all(), &lengths, IGRAPH_ALL);
+
+        for (igraph_integer_t to = from; to < vcount; ++to)
+        {
+            igraph_real_t distance = MATRIX(distances, 0, to);
+            if (distance == IGRAPH_INFINITY)
             {
-                igraph_add_edge(result, quotient_from, quotient_to);
+                continue;
+            }
+
+            igraph_real_t length = distance
+                + (VECTOR(*diameters)[from] + VECTOR(*diameters)[to]) / 2.0;
+            igraph_real_t count = VECTOR(*counts)[from]
+                + VECTOR(*counts)[to];
+            if (length > best_length
+                || (length == best_length && count > best_count))
+            {
+                best_length = length;
+                best_count = count;
+                best_from = from;
+                best_to = to;
             }
         }
+    }
+    igraph_matrix_destroy(&distances);
 
-        IGRAPH_EIT_NEXT(iterator);
+    igraph_vector_clear(path);
+    if (vcount > 0)
+    {
+        igraph_get_shortest_path_dijkstra(quotient, path, NULL, best_from,
+            best_to, &lengths, IGRAPH_ALL);
     }
 
-    // Destroy the iterator
-    igraph_eit_destroy(&iterator);
+    igraph_vector_destroy(&lengths);
+
+    return best_length;
+}
+
+igraph_integer_t quotient_diameter(igraph_t* quotient,
+    igraph_integer_t max_exact, igraph_vector_t* path, bool* exact)
+{
+    csr_t csr;
+    init_csr(&csr, quotient);
+    bfs_t bfs;
+    init_bfs(&bfs, &csr);
+
+    // The 4-sweep finds a long path, and a central root for iFUB
+    igraph_integer_t from, to, center;
+    igraph_integer_t diameter = four_sweep_ends(&bfs, &from, &to, &center);
+
+    // The sweeps only see the component of the highest degree cluster
+    bool connected = true;
+    for (igraph_integer_t v = 0; connected && v < csr.vcount; ++v)
+    {
+        connected = bfs.marks[v] == bfs.epoch;
+    }
+
+    // Small enough quotient graphs get the diameter of that component, iFUB
+    // starting from the path of the 4-sweep
+    bool small = max_exact == 0 || csr.vcount <= max_exact;
+    if (small)
+    {
+        diameter = ifub_diameter(&bfs, center, diameter, &from, &to, NULL);
+    }
+    *exact = small && connected;
+
+    shortest_path(&bfs, from, to, path);
+
+    destroy_bfs(&bfs);
+    destroy_csr(&csr);
 
-    // Destroy the selector
-    igraph_es_destroy(&selector);
+    return diameter;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include <igraph_datatype.h>
 
 /**
@@ -8,6 +10,41 @@
  * @param nb_clusters The number of clusters
  * @param membership The membership vector
  * @param result The quotient graph
+ * @param weights The number of edges of the input graph behind each edge of
+ * the quotient graph, initialized by the function, or NULL
+ * @param threads The number of threads collecting the edges
  */
 void quotient_graph(igraph_t* graph, igraph_integer_t nb_clusters,
-    igraph_vector_t* membership, igraph_t* result);
+    igraph_vector_t* membership, igraph_t* result, igraph_vector_t* weights,
+    int threads);
+
+/**
+ * @brief Compute the longest shortest path of the quotient graph, where
+ * each cluster counts as its diameter and each hop as one edge, the ends
+ * included (on ties, the path whose end clusters have the most vertices)
+ * @param quotient The quotient graph
+ * @param counts The number of vertices of each cluster
+ * @param diameters The diameter of each cluster
+ * @param path The clusters along the path, initialized
+ * @return The length of the path
+ */
+igraph_real_t quotient_weighted_longest_path(igraph_t* quotient,
+    igraph_vector_t* counts, igraph_vector_t* diameters,
+    igraph_vector_t* path);
+
+/**
+ * @brief Compute the diameter of the quotient graph and a longest shortest
+ * path, with iFUB from the center found by a 4-sweep, or with the 4-sweep
+ * only above a number of clusters
+ * @param quotient The quotient graph
+ * @param max_exact The number of clusters above which the diameter is only
+ * estimated (0 for no limit)
+ * @param path The clusters along the path, initialized
+ * @param exact Whether the diameter is exact (out, false when the quotient
+ * graph is disconnected)
+ * @return The diameter of the connected component of the highest degree
+ * cluster (the other components are not searched, the quotient of a
+ * connected graph being connected)
+ */
+igraph_integer_t quotient_diameter(igraph_t* quotient,
+    igraph_integer_t max_exact, igraph_vector_t* path, bool* exact);
@@ -0,0 +1,329 @@
+#include "report.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// The phases and the total, then the diameter
+#define REPORT_TIMED (BENCHMARK_PHASES + 1)
+
+static const char* column_names[REPORT_TIMED + 1] = {
+    "load",
+    "csr",
+    "graph",
+    "communities",
+    "quotient",
+    "quotient_diameter",
+    "sweeps",
+    "total",
+    "diameter",
+};
+
+// The times, then the hardware counters
+#define REPORT_TIMES 3
+#define REPORT_METRICS (REPORT_TIMES + STOPWATCH_COUNTERS)
+
+static const char* metric_names[REPORT_METRICS] = {
+    "real",
+    "user",
+    "sys",
+    "cycles",
+    "instructions",
+    "llc_misses",
+    "branch_misses",
+};
+
+#define REPORT_STATISTICS 6
+
+static const char* statistic_names[REPORT_STATISTICS] = {
+    "min",
+    "median",
+    "p95",
+    "max",
+    "mean",
+    "stddev",
+};
+
+static int report_metrics(void)
+{
+    return stopwatch_counters_opened() ? REPORT_METRICS : REPORT_TIMES;
+}
+
+static double metric_value(stopwatch_t* stopwatch, int metric)
+{
+    switch (metric)
+    {
+        case 0:
+            return stopwatch->real_time;
+        case 1:
+            return stopwatch->user_time;
+        case 2:
+            return stopwatch->system_time;
+        default:
+            return stopwatch->counters[metric - REPORT_TIMES];
+    }
+}
+
+static double record_value(benchmark_record_t* record, int column, int metric)
+{
+    if (column == REPORT_TIMED)
+    {
+        return record->diameter;
+    }
+    return metric_value(column < BENCHMARK_PHASES ? &record->phases[column]
+        : &record->total, metric);
+}
+
+static void print_metric(FILE* output, int metric, double value)
+{
+    // The times in seconds, the counters in events
+    fprintf(output, metric < REPORT_TIMES ? "%.9f" : "%.0f", value);
+}
+
+static int compare_doubles(const void* lhs, const void* rhs)
+{
+    double a = *(const double*) lhs;
+    double b = *(const double*) rhs;
+    return (a > b) - (a < b);
+}
+
+static void summarize(benchmark_record_t* records, int tries, int column,
+    int metric, double* statistics)
+{
+    double* values = malloc(tries * sizeof(double));
+    double sum = 0;
+    for (int i = 0; i < tries; ++i)
+    {
+        values[i] = record_value(&records[i], column, metric);
+        sum += values[i];
+    }
+    qsort(values, tries, sizeof(double), compare_doubles);
+
+    double mean = sum / tries;
+    double variance = 0;
+    for (int i = 0; i < tries; ++i)
+    {
+        variance += (values[i] - mean) * (values[i] - mean);
+    }
+
+    // The percentiles are taken with the nearest rank
+    statistics[0] = values[0];
+    statistics[1] = tries % 2 ? values[tries / 2]
+        : (values[tries / 2 - 1] + values[tries / 2]) / 2;
+    statistics[2] = values[(int) ceil(0.95 * tries) - 1];
+    statistics[3] = values[tries - 1];
+    statistics[4] = mean;
+    statistics[5] = sqrt(variance / tries);
+
+    free(values);
+}
+
+void lap_phase(benchmark_record_t* record, benchmark_phase_t phase,
+    stopwatch_point_t* point)
+{
+    stopwatch_point_t now;
+    create_stopwatch_point(&now);
+    increment_stopwatch(point, &now, &record->phases[phase]);
+    *point = now;
+}
+
+void begin_report(report_t* report, report_format_t format, FILE* output)
+{
+    report->format = format;
+    report->output = output;
+    report->functions = 0;
+
+    if (format == REPORT_FORMAT_JSON)
+    {
+        fprintf(output, "[");
+    }
+    else if (format == REPORT_FORMAT_CSV)
+    {
+        fprintf(output, "function,warm,flush_cache,try");
+        for (int column = 0; column < REPORT_TIMED; ++column)
+        {
+            for (int metric = 0; metric < report_metrics(); ++metric)
+            {
+                fprintf(output, ",%s_%s", column_names[column],
+                        metric_names[metric]);
+            }
+        }
+        fprintf(output, ",diameter\n");
+    }
+}
+
+static void print_stopwatch_json(FILE* output, stopwatch_t* stopwatch)
+{
+    fprintf(output, "{");
+    for (int metric = 0; metric < report_metrics(); ++metric)
+    {
+        fprintf(output, "%s\"%s\": ", metric ? ", " : "",
+                metric_names[metric]);
+        print_metric(output, metric, metric_value(stopwatch, metric));
+    }
+    fprintf(output, "}");
+}
+
+static void print_statistics_json(FILE* output, benchmark_record_t* records,
+    int tries, int column, int metric)
+{
+    double statistics[REPORT_STATISTICS];
+    summarize(records, tries, column, metric, statistics);
+
+    fprintf(output, "{");
+    for (int i = 0; i < REPORT_STATISTICS; ++i)
+    {
+        fprintf(output, "%s\"%s\": %.9f", i ? ", " : "",
+                statistic_names[i], statistics[i]);
+    }
+    fprintf(output, "}");
+}
+
+static void report_function_json(report_t* report, const char* function,
+    bool warm, bool flush_cache, stopwatch_t* load,
+    benchmark_record_t* records, int tries)
+{
+    FILE* output = report->output;
+
+    fprintf(output, "%s\n  {\n", report->functions ? "," : "");
+    fprintf(output, "    \"function\": \"%s\",\n", function);
+    fprintf(output, "    \"warm\": %s,\n", warm ? "true" : "false");
+    fprintf(output, "    \"flush_cache\": %s,\n",
+            flush_cache ? "true" : "false");
+    fprintf(output, "    \"load_once\": ");
+    if (warm)
+    {
+        print_stopwatch_json(output, load);
+    }
+    else
+    {
+        fprintf(output, "null");
+    }
+    fprintf(output, ",\n");
+
+    // Every try
+    fprintf(output, "    \"tries\": [");
+    for (int i = 0; i < tries; ++i)
+    {
+        fprintf(output, "%s\n      {", i ? "," : "");
+        for (int column = 0; column < REPORT_TIMED; ++column)
+        {
+            fprintf(output, "\"%s\": ", column_names[column]);
+            print_stopwatch_json(output, column < BENCHMARK_PHASES
+                ? &records[i].phases[column] : &records[i].total);
+            fprintf(output, ", ");
+        }
+        fprintf(output, "\"diameter\": %d}", records[i].diameter);
+    }
+    fprintf(output, "\n    ],\n");
+
+    // The statistics of each metric of each column
+    fprintf(output, "    \"statistics\": {");
+    for (int column = 0; column < REPORT_TIMED; ++column)
+    {
+        fprintf(output, "%s\n      \"%s\": {", column ? "," : "",
+                column_names[column]);
+        for (int metric = 0; metric < report_metrics(); ++metric)
+        {
+            fprintf(output, "%s\n        \"%s\": ", metric ? "," : "",
+                    metric_names[metric]);
+            print_statistics_json(output, records, tries, column, metric);
+        }
+        fprintf(output, "\n      }");
+    }
+    fprintf(output, ",\n      \"diameter\": ");
+    print_statistics_json(output, records, tries, REPORT_TIMED, 0);
+    fprintf(output, "\n    }\n  }");
+}
+
+static void report_function_csv(report_t* report, const char* function,
+    bool warm, bool flush_cache, stopwatch_t* load,
+    benchmark_record_t* records, int tries)
+{
+    FILE* output = report->output;
+    int metrics = report_metrics();
+
+    // Every try
+    for (int i = 0; i < tries; ++i)
+    {
+        fprintf(output, "%s,%d,%d,%d", function, warm, flush_cache, i);
+        for (int column = 0; column < REPORT_TIMED; ++column)
+        {
+            for (int metric = 0; metric < metrics; ++metric)
+            {
+                fprintf(output, ",");
+                print_metric(output, metric,
+                    record_value(&records[i], column, metric));
+            }
+        }
+        fprintf(output, ",%d\n", records[i].diameter);
+    }
+
+    if (warm)
+    {
+        // The single load
+        fprintf(output, "%s,%d,%d,once", function, warm, flush_cache);
+        for (int metric = 0; metric < metrics; ++metric)
+        {
+            fprintf(output, ",");
+            print_metric(output, metric, metric_value(load, metric));
+        }
+        for (int column = 1; column < REPORT_TIMED; ++column)
+        {
+            for (int metric = 0; metric < metrics; ++metric)
+            {
+                fprintf(output, ",");
+            }
+        }
+        fprintf(output, ",\n");
+    }
+
+    // The statistics of each metric of each column, then of the diameter
+    double statistics[REPORT_TIMED * REPORT_METRICS + 1][REPORT_STATISTICS];
+    int count = 0;
+    for (int column = 0; column < REPORT_TIMED; ++column)
+    {
+        for (int metric = 0; metric < metrics; ++metric)
+        {
+            summarize(records, tries, column, metric, statistics[count++]);
+        }
+    }
+    summarize(records, tries, REPORT_TIMED, 0, statistics[count++]);
+
+    for (int i = 0; i < REPORT_STATISTICS; ++i)
+    {
+        fprintf(output, "%s,%d,%d,%s", function, warm, flush_cache,
+                statistic_names[i]);
+        for (int j = 0; j < count; ++j)
+        {
+            fprintf(output, ",%.9f", statistics[j][i]);
+        }
+        fprintf(output, "\n");
+    }
+}
+
+void report_function(report_t* report, const char* function, bool warm,
+    bool flush_cache, stopwatch_t* load, benchmark_record_t* records,
+    int tries)
+{
+    if (report->format == REPORT_FORMAT_JSON)
+    {
+        report_function_json(report, function, warm, flush_cache, load,
+            records, tries);
+    }
+    else if (report->format == REPORT_FORMAT_CSV)
+    {
+        report_function_csv(report, function, warm, flush_cache, load,
+            records, tries);
+    }
+    fflush(report->output);
+
+    report->functions += 1;
+}
+
+void end_report(report_t* report)
+{
+    if (report->format == REPORT_FORMAT_JSON)
+    {
+        fprintf(report->output, "\n]\n");
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <igraph_datatype.h>
+
+#include "stopwatch.h"
+
+typedef enum report_format
+{
+    // The human readable averages
+    REPORT_FORMAT_TEXT,
+
+    // One object per function, with every try and the statistics
+    REPORT_FORMAT_JSON,
+
+    // One row per try, then one row per statistic
+    REPORT_FORMAT_CSV,
+} report_format_t;
+
+typedef enum benchmark_phase
+{
+    BENCHMARK_PHASE_LOAD,
+    BENCHMARK_PHASE_CSR,
+    BENCHMARK_PHASE_GRAPH,
+    BENCHMARK_PHASE_COMMUNITIES,
+    BENCHMARK_PHASE_QUOTIENT,
+    BENCHMARK_PHASE_QUOTIENT_DIAMETER,
+    BENCHMARK_PHASE_SWEEPS,
+    BENCHMARK_PHASES,
+} benchmark_phase_t;
+
+typedef struct benchmark_record
+{
+    // The times and hardware counters of each phase
+    stopwatch_t phases[BENCHMARK_PHASES];
+
+    // The times and hardware counters of the try, without the loading
+    stopwatch_t total;
+
+    igraph_integer_t diameter;
+} benchmark_record_t;
+
+typedef struct report
+{
+    report_format_t format;
+    FILE* output;
+
+    // The number of functions reported, to separate them
+    int functions;
+} report_t;
+
+/**
+ * @brief Add the time and the hardware counters since a stopwatch point to a
+ *        phase, and move the point to now
+ * @param record The record of the try
+ * @param phase The phase
+ * @param point The start of the phase, set to its end
+ */
+void lap_phase(benchmark_record_t* record, benchmark_phase_t phase,
+    stopwatch_point_t* point);
+
+/**
+ * @brief Start a report (the opening of the json array or the csv header)
+ * @param report The report to initialize
+ * @param format The format
+ * @param output The file
+ */
+void begin_report(report_t* report, report_format_t format, FILE* output);
+
+/**
+ * @brief Report the tries of a function, with the minimum, median, 95th
+ *        percentile, maximum, mean and standard deviation of each phase, of
+ *        the total and of the diameter (the real, user and system times, and
+ *        the hardware counters when opened)
+ * @param report The report
+ * @param function The name of the function
+ * @param warm Whether the graph was loaded once
+ * @param flush_cache Whether the caches were flushed before each try
+ * @param load The single load, when warm
+ * @param records The record of each try
+ * @param tries The number of tries
+ */
+void report_function(report_t* report, const char* function, bool warm,
+    bool flush_cache, stopwatch_t* load, benchmark_record_t* records,
+    int tries);
+
+/**
+ * @brief End a report (the closing of the json array)
+ * @param report The report
+ */
+void end_report(report_t* report);
@@ -1,18 +1,109 @@
+#define _DEFAULT_SOURCE
+
 #include "stopwatch.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+// The file descriptors of the hardware counters, -1 when closed
+static int counter_fds[STOPWATCH_COUNTERS] = {-1, -1, -1, -1};
+
+bool open_stopwatch_counters(void)
+{
+#ifdef __linux__
+    static const uint64_t events[STOPWATCH_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        // Count in user space only, which unprivileged users are allowed
+        // to, in the threads created afterwards too (as getrusage counts
+        // the whole process), with the times to scale the counts when the
+        // counters are multiplexed
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = events[i];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        counter_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counter_fds[i] == -1)
+        {
+            close_stopwatch_counters();
+            return false;
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void close_stopwatch_counters(void)
+{
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        if (counter_fds[i] != -1)
+        {
+            close(counter_fds[i]);
+            counter_fds[i] = -1;
+        }
+    }
+}
+
+bool stopwatch_counters_opened(void)
+{
+    return counter_fds[0] != -1;
+}
 
 void create_stopwatch_point(stopwatch_point_t* stopwatch_point)
 {
     clock_gettime(CLOCK_REALTIME, &(stopwatch_point->timespec));
     stopwatch_point->clock = clock();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    stopwatch_point->user_time =
+            usage.ru_utime.tv_usec * 1E-6 + usage.ru_utime.tv_sec;
+    stopwatch_point->system_time =
+            usage.ru_stime.tv_usec * 1E-6 + usage.ru_stime.tv_sec;
+
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        // The count, then the times the counter was enabled and running
+        uint64_t values[3];
+        stopwatch_point->counters[i] = 0;
+        if (counter_fds[i] != -1
+            && read(counter_fds[i], values, sizeof(values)) == sizeof(values)
+            && values[2] > 0)
+        {
+            // Estimate the count over the whole time the counter was enabled
+            stopwatch_point->counters[i] =
+                (uint64_t) ((double) values[0] * values[1] / values[2]);
+        }
+    }
 }
 
 void init_stopwatch(stopwatch_t* stopwatch)
 {
-    stopwatch->real_time = 0;
-    stopwatch->cpu_time = 0;
-    stopwatch->system_time = 0;
+    memset(stopwatch, 0, sizeof(stopwatch_t));
 }
 
 void create_stopwatch(stopwatch_point_t* start,
@@ -30,35 +121,44 @@ void create_stopwatch(stopwatch_point_t* start,
     stopwatch->cpu_time =
             ((double) (end->clock - start->clock)) / CLOCKS_PER_SEC;
 
-    // Compute user time
-    stopwatch->system_time = stopwatch->real_time - stopwatch->cpu_time;
+    // Compute user and system time
+    stopwatch->user_time = end->user_time - start->user_time;
+    stopwatch->system_time = end->system_time - start->system_time;
+
+    // Compute the hardware counters
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        stopwatch->counters[i] =
+                (double) (end->counters[i] - start->counters[i]);
+    }
 }
 
 void increment_stopwatch(stopwatch_point_t* start,
         stopwatch_point_t* end,
         stopwatch_t* stopwatch)
 {
-    // Compute real time
-    double real_time_start =
-            start->timespec.tv_nsec * 1E-9 + start->timespec.tv_sec;
-    double real_time_end =
-            end->timespec.tv_nsec * 1E-9 + end->timespec.tv_sec;
-    stopwatch->real_time += real_time_end - real_time_start;
-
-    // Compute cpu time
-    stopwatch->cpu_time +=
-            ((double) (end->clock - start->clock)) / CLOCKS_PER_SEC;
-
-    // Compute user time
-    stopwatch->system_time += stopwatch->real_time - stopwatch->cpu_time;
+    stopwatch_t elapsed;
+    create_stopwatch(start, end, &elapsed);
+    add_stopwatch(stopwatch, &elapsed, stopwatch);
 }
 
 void print_stopwatch(stopwatch_t* stopwatch)
 {
-    printf("(cpu: %fs | sys: %fs | real: %fs)",
+    printf("(cpu: %fs | user: %fs | sys: %fs | real: %fs)",
             stopwatch->cpu_time,
+            stopwatch->user_time,
             stopwatch->system_time,
             stopwatch->real_time);
+
+    if (stopwatch_counters_opened())
+    {
+        printf(" (cycles: %.0f | instructions: %.0f | llc misses: %.0f | "
+               "branch misses: %.0f)",
+                stopwatch->counters[STOPWATCH_CYCLES],
+                stopwatch->counters[STOPWATCH_INSTRUCTIONS],
+                stopwatch->counters[STOPWATCH_LLC_MISSES],
+                stopwatch->counters[STOPWATCH_BRANCH_MISSES]);
+    }
 }
 
 void add_stopwatch(stopwatch_t* lhs,
@@ -66,8 +166,13 @@ void add_stopwatch(stopwatch_t* lhs,
         stopwatch_t* result)
 {
     result->system_time = lhs->system_time + rhs->system_time;
+    result->user_time = lhs->user_time + rhs->user_time;
     result->cpu_time = lhs->cpu_time + rhs->cpu_time;
     result->real_time = lhs->real_time + rhs->real_time;
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        result->counters[i] = lhs->counters[i] + rhs->counters[i];
+    }
 }
 
 void subtract_stopwatch(stopwatch_t* lhs,
@@ -75,8 +180,13 @@ void subtract_stopwatch(stopwatch_t* lhs,
         stopwatch_t* result)
 {
     result->system_time = lhs->system_time - rhs->system_time;
+    result->user_time = lhs->user_time - rhs->user_time;
     result->cpu_time = lhs->cpu_time - rhs->cpu_time;
     result->real_time = lhs->real_time - rhs->real_time;
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        result->counters[i] = lhs->counters[i] - rhs->counters[i];
+    }
 }
 
 void multiply_stopwatch(stopwatch_t* lhs,
@@ -84,8 +194,13 @@ void multiply_stopwatch(stopwatch_t* lhs,
         stopwatch_t* result)
 {
     result->system_time = lhs->system_time * rhs->system_time;
+    result->user_time = lhs->user_time * rhs->user_time;
     result->cpu_time = lhs->cpu_time * rhs->cpu_time;
     result->real_time = lhs->real_time * rhs->real_time;
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        result->counters[i] = lhs->counters[i] * rhs->counters[i];
+    }
 }
 
 void divide_stopwatch(stopwatch_t* lhs,
@@ -93,8 +208,13 @@ void divide_stopwatch(stopwatch_t* lhs,
         stopwatch_t* result)
 {
     result->system_time = lhs->system_time / rhs->system_time;
+    result->user_time = lhs->user_time / rhs->user_time;
     result->cpu_time = lhs->cpu_time / rhs->cpu_time;
     result->real_time = lhs->real_time / rhs->real_time;
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        result->counters[i] = lhs->counters[i] / rhs->counters[i];
+    }
 }
 
 void multiply_scalar_stopwatch(stopwatch_t* lhs,
@@ -102,6 +222,11 @@ void multiply_scalar_stopwatch(stopwatch_t* lhs,
         stopwatch_t* result)
 {
     result->system_time = lhs->system_time * scalar;
+    result->user_time = lhs->user_time * scalar;
     result->cpu_time = lhs->cpu_time * scalar;
     result->real_time = lhs->real_time * scalar;
+    for (int i = 0; i < STOPWATCH_COUNTERS; ++i)
+    {
+        result->counters[i] = lhs->counters[i] * scalar;
+    }
 }
@@ -1,20 +1,62 @@
 #pragma once
 
+#include  <stdbool.h>
+#include  <stdint.h>
 #include  <time.h>
 
+typedef enum stopwatch_counter
+{
+    STOPWATCH_CYCLES,
+    STOPWATCH_INSTRUCTIONS,
+    STOPWATCH_LLC_MISSES,
+    STOPWATCH_BRANCH_MISSES,
+    STOPWATCH_COUNTERS,
+} stopwatch_counter_t;
+
 typedef struct stopwatch_point
 {
     struct timespec timespec;
     clock_t clock;
+
+    // The user and system time of the process (getrusage), in seconds
+    double user_time;
+    double system_time;
+
+    // The hardware counters of the process, when opened (scaled when
+    // multiplexed)
+    uint64_t counters[STOPWATCH_COUNTERS];
 } stopwatch_point_t;
 
 typedef struct stopwatch
 {
     double system_time;
+    double user_time;
     double cpu_time;
     double real_time;
+    double counters[STOPWATCH_COUNTERS];
 } stopwatch_t;
 
+/**
+ * @brief Open the hardware counters (cycles, instructions, last level cache
+ *        misses and branch misses) with perf_event_open, so that the
+ *        stopwatch points read them: the counters follow the calling thread
+ *        and the threads it creates afterwards, so they must be opened
+ *        before the first parallel region to count the whole process
+ * @return Whether the counters are available
+ */
+bool open_stopwatch_counters(void);
+
+/**
+ * @brief Close the hardware counters
+ */
+void close_stopwatch_counters(void);
+
+/**
+ * @brief Check whether the hardware counters are opened
+ * @return Whether the stopwatch points read the hardware counters
+ */
+bool stopwatch_counters_opened(void);
+
 /**
  * @brief Create a stopwatch point
  * @param stopwatch_point The stopwatch point struct to fill
@@ -1,221 +1,513 @@
 #include "sweep.h"
 
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include <igraph.h>
 
 #include "vector.h"
 
-typedef struct sweep_result
+typedef struct cluster_order
 {
-    igraph_integer_t max_distance;
-    igraph_integer_t last_vertex;
-} sweep_result_t;
+    uint64_t size;
+    uint32_t cluster;
+} cluster_order_t;
 
-static igraph_bool_t sweep_callback(const igraph_t* graph,
-    igraph_integer_t vid, igraph_integer_t pred, igraph_integer_t succ,
-    igraph_integer_t rank, igraph_integer_t dist, void* extra)
+static int compare_cluster_order(const void* lhs, const void* rhs)
 {
-    (void) graph;
-    (void) pred;
-    (void) succ;
-    (void) rank;
+    const cluster_order_t* left = lhs;
+    const cluster_order_t* right = rhs;
 
-    sweep_result_t* stats = extra;
-    stats->max_distance = dist;
-    stats->last_vertex = vid;
-
-    return false;
+    // Largest first, then by id
+    if (left->size != right->size)
+    {
+        return left->size < right->size ? 1 : -1;
+    }
+    return left->cluster < right->cluster ? -1 : left->cluster > right->cluster;
 }
 
-static void compute_cluster_statistics(igraph_t* graph,
-    igraph_vector_t* membership, igraph_integer_t cluster,
-    igraph_integer_t* count, igraph_integer_t* diameter)
+static igraph_integer_t compute_cluster_diameter(csr_t* graph,
+    clusters_t* clusters, const uint32_t* local, uint32_t cluster)
 {
-    igraph_integer_t vcount = igraph_vcount(graph);
-
-    // Compute all the vertices in the cluster
-    igraph_vector_t vertices;
-    igraph_vector_init(&vertices, 0);
-
-    for (igraph_integer_t i = 0; i < vcount; ++i)
+    uint64_t count = cluster_size(clusters, cluster);
+    if (count <= 1)
     {
-        igraph_integer_t current = VECTOR(*membership)[i];
-        if (current == cluster)
-        {
-            igraph_vector_push_back(&vertices, i);
-        }
+        return 0;
     }
 
-    *count = igraph_vector_size(&vertices);
+    // Sweep on the induced subgraph, so that only the memory of the cluster
+    // is touched
+    csr_t induced;
+    init_induced_csr(&induced, graph,
+        clusters->vertices + clusters->offsets[cluster], count,
+        clusters->membership, local);
+    bfs_t bfs;
+    init_bfs(&bfs, &induced);
 
-    // First sweep
-    sweep_result_t stats;
-    igraph_bfs(graph, VECTOR(vertices)[0], NULL, IGRAPH_ALL, false,
-        &vertices, NULL, NULL, NULL, NULL, NULL,
-        NULL, sweep_callback, &stats);
-    *diameter = stats.max_distance;
+    // First sweep (local vertex 0 is the first vertex of the cluster)
+    sweep_result_t stats = bfs_sweep(&bfs, 0);
+    igraph_integer_t diameter = stats.max_distance;
 
     // Double sweep
-    igraph_bfs(graph, stats.last_vertex, NULL, IGRAPH_ALL, false,
-        &vertices, NULL, NULL, NULL, NULL, NULL,
-        NULL, sweep_callback, &stats);
-    if (stats.max_distance > *diameter)
+    stats = bfs_sweep(&bfs, stats.last_vertex);
+    if (stats.max_distance > diameter)
     {
-        *diameter = stats.max_distance;
+        diameter = stats.max_distance;
     }
 
-    igraph_vector_destroy(&vertices);
+    destroy_bfs(&bfs);
+    destroy_csr(&induced);
+
+    return diameter;
 }
 
-void compute_clusters_statistics(igraph_t* graph, igraph_integer_t nb_clusters,
-    igraph_vector_t* membership, igraph_vector_t* counts,
-    igraph_vector_t* diameters)
+void compute_clusters_statistics(bfs_t* bfs, clusters_t* clusters,
+    igraph_vector_t* counts, igraph_vector_t* diameters)
 {
+    igraph_integer_t vcount = bfs->graph->vcount;
+    igraph_integer_t nb_clusters = clusters->nb_clusters;
+
     // Initialize the counts
     igraph_vector_init(counts, nb_clusters);
 
     // Initialize the diameters
     igraph_vector_init(diameters, nb_clusters);
 
+    // Compute the index of each vertex in its cluster
+    uint32_t* local = malloc(vcount * sizeof(uint32_t));
+    for (igraph_integer_t c = 0; c < nb_clusters; ++c)
+    {
+        for (uint64_t i = clusters->offsets[c]; i < clusters->offsets[c + 1]; ++i)
+        {
+            local[clusters->vertices[i]] = i - clusters->offsets[c];
+        }
+    }
+
+    // Schedule the largest clusters first, so that they do not end last
+    cluster_order_t* order = malloc(nb_clusters * sizeof(cluster_order_t));
+    for (igraph_integer_t c = 0; c < nb_clusters; ++c)
+    {
+        order[c].size = cluster_size(clusters, c);
+        order[c].cluster = c;
+    }
+    qsort(order, nb_clusters, sizeof(cluster_order_t), compare_cluster_order);
+
     // Compute the statistics
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(bfs->threads)
     for (igraph_integer_t i = 0; i < nb_clusters; ++i)
     {
-        igraph_integer_t count;
-        igraph_integer_t diameter;
-        compute_cluster_statistics(graph, membership, i, &count, &diameter);
-        VECTOR(*counts)[i] = count;
-        VECTOR(*diameters)[i] = diameter;
+        uint32_t cluster = order[i].cluster;
+        VECTOR(*counts)[cluster] = order[i].size;
+        VECTOR(*diameters)[cluster] = compute_cluster_diameter(bfs->graph,
+            clusters, local, cluster);
     }
+
+    free(order);
+    free(local);
 }
 
-void compute_statistics(igraph_t* graph, igraph_integer_t* count,
+void compute_statistics(bfs_t* bfs, igraph_integer_t* count,
     igraph_integer_t* diameter)
 {
-    *count = igraph_vcount(graph);
-    *diameter = double_sweep(graph);
+    *count = bfs->graph->vcount;
+    *diameter = double_sweep(bfs);
 }
 
-igraph_integer_t double_sweep(igraph_t* graph)
+igraph_integer_t double_sweep_ends(bfs_t* bfs, igraph_integer_t* from,
+    igraph_integer_t* to)
 {
     igraph_integer_t diameter;
+    igraph_integer_t diameter_from = 0;
 
     // First sweep
-    sweep_result_t stats;
-    igraph_bfs(graph, 0, NULL, IGRAPH_ALL, false,
-        NULL, NULL, NULL, NULL, NULL, NULL,
-        NULL, sweep_callback, &stats);
+    sweep_result_t stats = bfs_sweep(bfs, 0);
     diameter = stats.max_distance;
+    igraph_integer_t diameter_to = stats.last_vertex;
 
     // Double sweep
-    igraph_bfs(graph, stats.last_vertex, NULL, IGRAPH_ALL, false,
-        NULL, NULL, NULL, NULL, NULL, NULL,
-        NULL, sweep_callback, &stats);
+    igraph_integer_t farthest = stats.last_vertex;
+    stats = bfs_sweep(bfs, farthest);
     if (stats.max_distance > diameter)
     {
         diameter = stats.max_distance;
+        diameter_from = farthest;
+        diameter_to = stats.last_vertex;
+    }
+
+    if (from)
+    {
+        *from = diameter_from;
+    }
+
+    if (to)
+    {
+        *to = diameter_to;
     }
 
     return diameter;
 }
 
-igraph_integer_t double_sweep_from_community(igraph_t* graph,
-    igraph_vector_t* membership, igraph_integer_t starting_community)
+igraph_integer_t double_sweep(bfs_t* bfs)
 {
-    igraph_integer_t vcount = igraph_vcount(graph);
-
-    igraph_integer_t diameter = 0;
+    return double_sweep_ends(bfs, NULL, NULL);
+}
 
-    for (igraph_integer_t i = 0; i < vcount; ++i)
+// Compute the double sweep from each start (batched if enabled)
+static void double_sweeps(bfs_t* bfs, const uint32_t* starts, size_t count,
+    igraph_integer_t* diameters)
+{
+    if (!bfs->batched)
     {
-        igraph_integer_t community = VECTOR(*membership)[i];
-        if (community == starting_community)
+        for (size_t i = 0; i < count; ++i)
         {
             // First sweep
-            sweep_result_t stats;
-            igraph_bfs(graph, i, NULL, IGRAPH_ALL, false,
-                NULL, NULL, NULL, NULL, NULL, NULL,
-                NULL, sweep_callback, &stats);
-            if (stats.max_distance > diameter)
+            sweep_result_t stats = bfs_sweep(bfs, starts[i]);
+            diameters[i] = stats.max_distance;
+
+            // Double sweep
+            stats = bfs_sweep(bfs, stats.last_vertex);
+            if (stats.max_distance > diameters[i])
             {
-                diameter = stats.max_distance;
+                diameters[i] = stats.max_distance;
             }
+        }
+        return;
+    }
 
-            // Double sweep
-            igraph_bfs(graph, stats.last_vertex, NULL, IGRAPH_ALL, false,
-                NULL, NULL, NULL, NULL, NULL, NULL,
-                NULL, sweep_callback, &stats);
-            if (stats.max_distance > diameter)
+    sweep_result_t stats[BFS_BATCH_SIZE];
+    uint32_t farthest[BFS_BATCH_SIZE];
+
+    for (size_t batch = 0; batch < count; batch += BFS_BATCH_SIZE)
+    {
+        size_t size = count - batch < BFS_BATCH_SIZE
+            ? count - batch : BFS_BATCH_SIZE;
+
+        // First sweeps
+        bfs_multi_sweep(bfs, starts + batch, size, stats);
+        for (size_t i = 0; i < size; ++i)
+        {
+            diameters[batch + i] = stats[i].max_distance;
+            farthest[i] = stats[i].last_vertex;
+        }
+
+        // Double sweeps
+        bfs_multi_sweep(bfs, farthest, size, stats);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (stats[i].max_distance > diameters[batch + i])
             {
-                diameter = stats.max_distance;
+                diameters[batch + i] = stats[i].max_distance;
             }
         }
     }
+}
 
-    return diameter;
+void init_community_sweep(community_sweep_t* sweep, bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t community,
+    igraph_integer_t max_tries)
+{
+    sweep->bfs = bfs;
+    sweep->clusters = clusters;
+    sweep->community = community;
+    sweep->max_tries = max_tries;
+    sweep->position = clusters->offsets[community];
+    sweep->buffered = 0;
+    sweep->next = 0;
+    sweep->tries = 0;
+    sweep->diameter = 0;
+    sweep->stable = 0;
 }
 
-igraph_integer_t double_sweep_from_community_tries(igraph_t* graph,
-    igraph_vector_t* membership, igraph_integer_t starting_community,
-    igraph_integer_t tries, bool verbose)
+// Compute the double sweeps of the next starts of the community (a whole batch
+// at once if batched, one otherwise)
+static size_t fill_community_sweep(community_sweep_t* sweep)
 {
-    igraph_integer_t vcount = igraph_vcount(graph);
+    uint64_t end = sweep->clusters->offsets[sweep->community + 1];
 
-    igraph_integer_t diameter = 0;
-    igraph_integer_t try = 0;
+    size_t capacity = sweep->bfs->batched ? BFS_BATCH_SIZE : 1;
+    if (sweep->max_tries >= 0
+        && (igraph_integer_t) capacity > sweep->max_tries - sweep->tries)
+    {
+        capacity = sweep->max_tries - sweep->tries;
+    }
+
+    uint32_t starts[BFS_BATCH_SIZE];
+    size_t count = 0;
+
+    for (; sweep->position < end && count < capacity; ++sweep->position)
+    {
+        starts[count++] = sweep->clusters->vertices[sweep->position];
+    }
+
+    double_sweeps(sweep->bfs, starts, count, sweep->diameters);
+
+    sweep->buffered = count;
+    sweep->next = 0;
+
+    return count;
+}
+
+bool community_sweep_next(community_sweep_t* sweep)
+{
+    if (sweep->next == sweep->buffered && fill_community_sweep(sweep) == 0)
+    {
+        return false;
+    }
+
+    igraph_integer_t diameter = sweep->diameters[sweep->next++];
+    sweep->tries += 1;
+
+    if (diameter > sweep->diameter)
+    {
+        sweep->diameter = diameter;
+        sweep->stable = 0;
+    }
+    else
+    {
+        sweep->stable += 1;
+    }
+
+    return true;
+}
+
+igraph_integer_t double_sweep_from_community(bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t starting_community)
+{
+    community_sweep_t sweep;
+    init_community_sweep(&sweep, bfs, clusters, starting_community, -1);
+
+    while (community_sweep_next(&sweep))
+    {
+    }
+
+    return sweep.diameter;
+}
+
+igraph_integer_t double_sweep_from_community_tries(bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t starting_community,
+    igraph_integer_t tries, bool verbose)
+{
+    community_sweep_t sweep;
+    init_community_sweep(&sweep, bfs, clusters, starting_community, tries);
 
     if (verbose)
     {
         fprintf(stderr, "(");
     }
 
-    for (igraph_integer_t i = 0; i < vcount; ++i)
+    while (community_sweep_next(&sweep))
     {
-        igraph_integer_t community = VECTOR(*membership)[i];
-        if (community == starting_community)
+        if (sweep.tries >= tries)
         {
-            // First sweep
-            sweep_result_t stats;
-            igraph_bfs(graph, i, NULL, IGRAPH_ALL, false,
-                NULL, NULL, NULL, NULL, NULL, NULL,
-                NULL, sweep_callback, &stats);
-            if (stats.max_distance > diameter)
-            {
-                diameter = stats.max_distance;
-            }
+            break;
+        }
 
-            // Double sweep
-            igraph_bfs(graph, stats.last_vertex, NULL, IGRAPH_ALL, false,
-                NULL, NULL, NULL, NULL, NULL, NULL,
-                NULL, sweep_callback, &stats);
-            if (stats.max_distance > diameter)
+        if (verbose)
+        {
+            fprintf(stderr, "try %d: %d", sweep.tries, sweep.diameter);
+
+            if (sweep.tries != tries - 1)
             {
-                diameter = stats.max_distance;
+                fprintf(stderr, " | ");
             }
+        }
+    }
+
+    if (verbose)
+    {
+        fprintf(stderr, ") ");
+    }
+
+    return sweep.diameter;
+}
+
+static igraph_integer_t highest_degree_vertex(csr_t* graph)
+{
+    igraph_integer_t vertex = 0;
+    for (igraph_integer_t i = 1; i < graph->vcount; ++i)
+    {
+        if (csr_degree(graph, i) > csr_degree(graph, vertex))
+        {
+            vertex = i;
+        }
+    }
+    return vertex;
+}
+
+// Write the distance of each vertex visited by the last bfs_levels call
+static void level_distances(bfs_t* bfs, size_t* levels,
+    igraph_integer_t eccentricity, uint32_t* distances)
+{
+    for (igraph_integer_t d = 0; d <= eccentricity; ++d)
+    {
+        for (size_t i = levels[d]; i < levels[d + 1]; ++i)
+        {
+            distances[bfs->queue[i]] = d;
+        }
+    }
+}
+
+// Walk back from the end of a shortest path to the vertex halfway to the source
+static igraph_integer_t path_midpoint(bfs_t* bfs, uint32_t* distances,
+    igraph_integer_t end)
+{
+    csr_t* graph = bfs->graph;
 
-            try += 1;
+    uint32_t vertex = end;
+    uint32_t middle = distances[end] / 2;
 
-            if (try >= tries)
+    while (distances[vertex] > middle)
+    {
+        for (uint64_t i = graph->offsets[vertex];
+             i < graph->offsets[vertex + 1]; ++i)
+        {
+            uint32_t neighbor = graph->neighbors[i];
+            if (bfs->marks[neighbor] == bfs->epoch
+                && distances[neighbor] + 1 == distances[vertex])
             {
+                vertex = neighbor;
                 break;
             }
+        }
+    }
+
+    return vertex;
+}
+
+igraph_integer_t four_sweep_ends(bfs_t* bfs, igraph_integer_t* from,
+    igraph_integer_t* to, igraph_integer_t* center)
+{
+    igraph_integer_t vcount = bfs->graph->vcount;
+
+    size_t* levels = malloc((vcount + 1) * sizeof(size_t));
+    uint32_t* distances = malloc(vcount * sizeof(uint32_t));
+
+    igraph_integer_t diameter = 0;
+    igraph_integer_t start = highest_degree_vertex(bfs->graph);
+    igraph_integer_t diameter_from = start;
+    igraph_integer_t diameter_to = start;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        // First sweep
+        sweep_result_t stats = bfs_sweep(bfs, start);
+        if (stats.max_distance > diameter)
+        {
+            diameter = stats.max_distance;
+            diameter_from = start;
+            diameter_to = stats.last_vertex;
+        }
+
+        // Double sweep, keeping the distances to find the midpoint
+        igraph_integer_t farthest = stats.last_vertex;
+        stats = bfs_levels(bfs, farthest, levels);
+        if (stats.max_distance > diameter)
+        {
+            diameter = stats.max_distance;
+            diameter_from = farthest;
+            diameter_to = stats.last_vertex;
+        }
+
+        // Restart from the middle of the path
+        level_distances(bfs, levels, stats.max_distance, distances);
+        start = path_midpoint(bfs, distances, stats.last_vertex);
+    }
+
+    free(distances);
+    free(levels);
+
+    if (from)
+    {
+        *from = diameter_from;
+    }
+
+    if (to)
+    {
+        *to = diameter_to;
+    }
+
+    if (center)
+    {
+        *center = start;
+    }
+
+    return diameter;
+}
+
+igraph_integer_t four_sweep(bfs_t* bfs)
+{
+    return four_sweep_ends(bfs, NULL, NULL, NULL);
+}
+
+igraph_integer_t sum_sweep_ends(bfs_t* bfs, igraph_integer_t sweeps,
+    igraph_integer_t* from, igraph_integer_t* to)
+{
+    igraph_integer_t vcount = bfs->graph->vcount;
+
+    size_t* levels = malloc((vcount + 1) * sizeof(size_t));
+    uint64_t* sums = calloc(vcount, sizeof(uint64_t));
+    bool* used = calloc(vcount, sizeof(bool));
+
+    igraph_integer_t diameter = 0;
+    igraph_integer_t source = highest_degree_vertex(bfs->graph);
+    igraph_integer_t diameter_from = source;
+    igraph_integer_t diameter_to = source;
 
-            if (verbose)
+    for (igraph_integer_t sweep = 0; sweep < sweeps; ++sweep)
+    {
+        sweep_result_t stats = bfs_levels(bfs, source, levels);
+        used[source] = true;
+
+        if (stats.max_distance > diameter)
+        {
+            diameter = stats.max_distance;
+            diameter_from = source;
+            diameter_to = stats.last_vertex;
+        }
+
+        // Add the distances to the source
+        for (igraph_integer_t d = 1; d <= stats.max_distance; ++d)
+        {
+            for (size_t i = levels[d]; i < levels[d + 1]; ++i)
             {
-                fprintf(stderr, "try %d: %d", try, diameter);
+                sums[bfs->queue[i]] += d;
+            }
+        }
 
-                if (try != tries - 1)
-                {
-                    fprintf(stderr, " | ");
-                }
+        // Take the unused vertex with the largest sum of distances
+        source = -1;
+        for (igraph_integer_t i = 0; i < vcount; ++i)
+        {
+            if (!used[i] && (source == -1 || sums[i] > sums[source]))
+            {
+                source = i;
             }
         }
+
+        if (source == -1)
+        {
+            break;
+        }
     }
 
-    if (verbose)
+    free(used);
+    free(sums);
+    free(levels);
+
+    if (from)
     {
-        fprintf(stderr, ") ");
+        *from = diameter_from;
+    }
+
+    if (to)
+    {
+        *to = diameter_to;
     }
 
     return diameter;
 }
+
+igraph_integer_t sum_sweep(bfs_t* bfs, igraph_integer_t sweeps)
+{
+    return sum_sweep_ends(bfs, sweeps, NULL, NULL);
+}
@@ -1,57 +1,175 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include <igraph_datatype.h>
 
+#include "bfs.h"
+#include "clusters.h"
+
+typedef enum sweep_strategy
+{
+    // Double sweep from vertex 0
+    SWEEP_STRATEGY_DOUBLE,
+
+    // Double sweeps from the highest degree vertex, then from the midpoint
+    SWEEP_STRATEGY_FOUR,
+
+    // Sweeps from the vertices with the largest sum of distances
+    SWEEP_STRATEGY_SUM,
+} sweep_strategy_t;
+
+typedef struct community_sweep
+{
+    bfs_t* bfs;
+    clusters_t* clusters;
+    igraph_integer_t community;
+    igraph_integer_t max_tries;
+
+    // The position of the next start in the vertices of the clusters
+    uint64_t position;
+
+    // The double sweeps computed ahead (a whole batch if batched)
+    igraph_integer_t diameters[BFS_BATCH_SIZE];
+    size_t buffered;
+    size_t next;
+
+    // The number of double sweeps done
+    igraph_integer_t tries;
+
+    // The maximum diameter found so far
+    igraph_integer_t diameter;
+
+    // The number of tries since the diameter last improved
+    igraph_integer_t stable;
+} community_sweep_t;
+
+// The number of sweeps of SumSweep, the budget of a 4-sweep
+#define SUM_SWEEP_DEFAULT_SWEEPS 4
+
 /**
- * @brief Compute statistics for each cluster
- * @param graph The graph
- * @param nb_clusters The number of clusters
- * @param membership The membership of each vertex
+ * @brief Compute statistics for each cluster, in parallel with the threads of
+ *        the bfs (each cluster is swept on its own induced subgraph)
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
  * @param counts The number of vertices in each cluster (out)
  * @param diameters An approximation (double sweep) of the diameter of each cluster (out)
  */
-void compute_clusters_statistics(igraph_t* graph, igraph_integer_t nb_clusters,
-    igraph_vector_t* membership, igraph_vector_t* counts,
-    igraph_vector_t* diameters);
+void compute_clusters_statistics(bfs_t* bfs, clusters_t* clusters,
+    igraph_vector_t* counts, igraph_vector_t* diameters);
 
 /**
  * @brief Compute statistics for the graph
- * @param graph The graph
+ * @param bfs The bfs over the graph
  * @param count The number of vertices in the graph (out)
  * @param diameter An approximation (double sweep) of the diameter of the graph (out)
  */
-void compute_statistics(igraph_t* graph, igraph_integer_t* count,
+void compute_statistics(bfs_t* bfs, igraph_integer_t* count,
     igraph_integer_t* diameter);
 
 /**
  * @brief Compute the double sweep
- * @param graph The graph
+ * @param bfs The bfs over the graph
  * @return An approximation of the diameter of the graph
  */
-igraph_integer_t double_sweep(igraph_t* graph);
+igraph_integer_t double_sweep(bfs_t* bfs);
+
+/**
+ * @brief Compute the double sweep, with the ends of the longest path it found
+ * @param bfs The bfs over the graph
+ * @param from The source of the sweep that found the longest path (out, can
+ *             be NULL)
+ * @param to The farthest vertex of that sweep (out, can be NULL)
+ * @return An approximation of the diameter of the graph
+ */
+igraph_integer_t double_sweep_ends(bfs_t* bfs, igraph_integer_t* from,
+    igraph_integer_t* to);
 
 /**
  * @brief Compute the double sweep starting from a community
- * @param graph The graph
- * @param membership The membership of each vertex
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
  * @param starting_community The start of the double sweeps will be taken from this community
  * @return An approximation of the diameter of the graph
  */
-igraph_integer_t double_sweep_from_community(igraph_t* graph,
-    igraph_vector_t* membership, igraph_integer_t starting_community);
+igraph_integer_t double_sweep_from_community(bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t starting_community);
+
+/**
+ * @brief Start double sweeps from the vertices of a community, one try at a time
+ * @param sweep The community sweep to initialize
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
+ * @param community The start of the double sweeps will be taken from this community
+ * @param max_tries The maximum number of tries (-1 for all the vertices),
+ *                  so that a batch does not compute more than needed
+ */
+void init_community_sweep(community_sweep_t* sweep, bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t community,
+    igraph_integer_t max_tries);
+
+/**
+ * @brief Do the next try of a community sweep, updating its tries, diameter
+ *        (the running maximum) and stable count
+ * @param sweep The community sweep
+ * @return Whether a try was done (false once the community or max_tries is exhausted)
+ */
+bool community_sweep_next(community_sweep_t* sweep);
 
 /**
  * @brief Compute the double sweep starting from a community with a certain number of tries
- * @param graph The graph
- * @param membership The membership of each vertex
+ * @param bfs The bfs over the graph
+ * @param clusters The clusters
  * @param starting_community The start of the double sweeps will be taken from this community
  * @param tries The number of different starts from the starting community
  *              (if the number of nodes in the community is lower, then tries=the number of nodes in the community)
  * @param verbose print the diameter for all the tries from 0 to 'tries'
  * @return An approximation of the diameter of the graph
  */
-igraph_integer_t double_sweep_from_community_tries(igraph_t* graph,
-    igraph_vector_t* membership, igraph_integer_t starting_community,
+igraph_integer_t double_sweep_from_community_tries(bfs_t* bfs,
+    clusters_t* clusters, igraph_integer_t starting_community,
     igraph_integer_t tries, bool verbose);
+
+/**
+ * @brief Compute the 4-sweep (Crescenzi et al.): a double sweep from the
+ *        highest degree vertex, then another one from the midpoint of the path
+ *        it found
+ * @param bfs The bfs over the graph
+ * @return An approximation of the diameter of the graph (4 breadth first searches)
+ */
+igraph_integer_t four_sweep(bfs_t* bfs);
+
+/**
+ * @brief Compute the 4-sweep, with the ends of the longest path it found
+ * @param bfs The bfs over the graph
+ * @param from The source of the longest path (out, can be NULL)
+ * @param to The other end of the longest path (out, can be NULL)
+ * @param center The midpoint of the last double sweep, a central vertex
+ *               (out, can be NULL)
+ * @return An approximation of the diameter of the graph (4 breadth first searches)
+ */
+igraph_integer_t four_sweep_ends(bfs_t* bfs, igraph_integer_t* from,
+    igraph_integer_t* to, igraph_integer_t* center);
+
+/**
+ * @brief Compute SumSweep (Borassi et al.): sweep from the highest degree
+ *        vertex, then from the vertex with the largest sum of distances to the
+ *        previous sources
+ * @param bfs The bfs over the graph
+ * @param sweeps The number of breadth first searches
+ * @return An approximation of the diameter of the graph
+ */
+igraph_integer_t sum_sweep(bfs_t* bfs, igraph_integer_t sweeps);
+
+/**
+ * @brief Compute SumSweep, with the ends of the longest path it found
+ * @param bfs The bfs over the graph
+ * @param sweeps The number of breadth first searches
+ * @param from The source of the sweep that found the longest path (out, can
+ *             be NULL)
+ * @param to The farthest vertex of that sweep (out, can be NULL)
+ * @return An approximation of the diameter of the graph
+ */
+igraph_integer_t sum_sweep_ends(bfs_t* bfs, igraph_integer_t sweeps,
+    igraph_integer_t* from, igraph_integer_t* to);